@@ -0,0 +1,175 @@
+#include "actor.h"
+
+#include <cmath>
+#include <iostream>
+
+#include "blockmap.h"
+#include "engine.h"
+#include "jobs.h"
+#include "physics.h"
+#include "sectormap.h"
+
+// next pseudo random number of an actor, a plain linear congruential generator
+static unsigned int wanderRandom(Actors* actors, int e) {
+	actors->seed[e] = actors->seed[e] * 1664525u + 1013904223u;
+	return actors->seed[e] >> 8;
+}
+
+void clearActors(Actors* actors) {
+	int i;
+
+	// bump every generation so handles from the last map go stale, and chain all slots as free
+	for (i = 0; i < maxActors; i++) {
+		actors->slotEntry[i] = -1;
+		actors->slotGeneration[i]++;
+		actors->nextFree[i] = i + 1;
+	}
+	actors->nextFree[maxActors - 1] = -1;
+	actors->freeHead = 0;
+	actors->count = 0;
+	actors->spawned = 0;
+}
+
+ActorHandle spawnActor(Engine* engine, int x, int y, int angle) {
+	ActorHandle handle = { -1, 0 };
+	Actors* actors = &engine->actors;
+	const MapData* map = engine->map.get();
+
+	if (actors->freeHead < 0) {
+		std::cout << "Actors exceed the limit of " << maxActors << std::endl;
+		return handle;
+	}
+	int s = actors->freeHead;
+	actors->freeHead = actors->nextFree[s];
+
+	int e = actors->count++;
+	actors->slotEntry[s] = e;
+	actors->slot[e] = s;
+
+	int floor, ceiling;
+	actors->x[e] = x;
+	actors->y[e] = y;
+	actors->sector[e] = findSector(map, x, y);
+	sectorSpan(map, actors->sector[e], groundHeight, &floor, &ceiling);
+	actors->z[e] = floor;
+	actors->angle[e] = ((angle % 360) + 360) % 360;
+	actors->velX[e] = 0;
+	actors->velY[e] = 0;
+	actors->velZ[e] = 0;
+	actors->state[e] = ACTOR_IDLE;
+	actors->tics[e] = 0;
+	actors->seed[e] = ++actors->spawned * 2654435761u;
+
+	handle.slot = s;
+	handle.generation = actors->slotGeneration[s];
+	return handle;
+}
+
+bool removeActor(Actors* actors, ActorHandle handle) {
+	int e = actorEntry(actors, handle);
+
+	if (e < 0) {
+		return false;
+	}
+
+	// move the last entry into the hole to keep the arrays packed
+	int last = actors->count - 1;
+	if (e != last) {
+		actors->x[e] = actors->x[last];
+		actors->y[e] = actors->y[last];
+		actors->z[e] = actors->z[last];
+		actors->angle[e] = actors->angle[last];
+		actors->velX[e] = actors->velX[last];
+		actors->velY[e] = actors->velY[last];
+		actors->velZ[e] = actors->velZ[last];
+		actors->sector[e] = actors->sector[last];
+		actors->state[e] = actors->state[last];
+		actors->tics[e] = actors->tics[last];
+		actors->seed[e] = actors->seed[last];
+		actors->slot[e] = actors->slot[last];
+		actors->slotEntry[actors->slot[e]] = e;
+	}
+	actors->count--;
+
+	actors->slotEntry[handle.slot] = -1;
+	actors->slotGeneration[handle.slot]++;
+	actors->nextFree[handle.slot] = actors->freeHead;
+	actors->freeHead = handle.slot;
+	return true;
+}
+
+int actorEntry(const Actors* actors, ActorHandle handle) {
+	if (handle.slot < 0 || handle.slot >= maxActors || actors->slotGeneration[handle.slot] != handle.generation) {
+		return -1;
+	}
+	return actors->slotEntry[handle.slot];
+}
+
+static void thinkRange(int begin, int end, void* data) {
+	int e;
+	Engine* engine = static_cast<Engine*>(data);
+	Actors* actors = &engine->actors;
+	const Player* player = &engine->player;
+	const Rotation* rot = engine->rot.get();
+
+	for (e = begin; e < end; e++) {
+		// map coordinates are not bounded, so far apart ones overflow an int once squared
+		long long dx = static_cast<long long>(player->x) - actors->x[e];
+		long long dy = static_cast<long long>(player->y) - actors->y[e];
+
+		if (dx * dx + dy * dy < chaseRange * chaseRange) {
+			// angles count clockwise from +y, matching the player's movement
+			int angle = static_cast<int>(std::atan2(static_cast<float>(dx), static_cast<float>(dy)) * 180.0f / PI);
+			actors->angle[e] = (angle + 360) % 360;
+			actors->state[e] = ACTOR_CHASE;
+			actors->tics[e] = 0;
+		}
+		else if (--actors->tics[e] <= 0) {
+			actors->angle[e] = wanderRandom(actors, e) % 360;
+			actors->state[e] = ACTOR_WANDER;
+			actors->tics[e] = wanderTics;
+		}
+
+		actors->velX[e] = static_cast<int>(rot->sin[actors->angle[e]] * actorSpeed);
+		actors->velY[e] = static_cast<int>(rot->cos[actors->angle[e]] * actorSpeed);
+	}
+}
+
+void thinkActors(Engine* engine) {
+	parallelFor(engine->actors.count, actorGrain, thinkRange, engine);
+}
+
+static void moveRange(int begin, int end, void* data) {
+	int e;
+	Engine* engine = static_cast<Engine*>(data);
+	Actors* actors = &engine->actors;
+	const MapData* map = engine->map.get();
+
+	for (e = begin; e < end; e++) {
+		int x = actors->x[e];
+		int y = actors->y[e];
+		int z = actors->z[e];
+
+		if (actors->velX[e] != 0 || actors->velY[e] != 0) {
+			slideMove(map, &x, &y, actors->velX[e], actors->velY[e], actorRadius, z + stepHeight, z + playerHeight);
+			if (x == actors->x[e] && y == actors->y[e]) {
+				// stuck against a wall, pick a new direction next tick
+				actors->tics[e] = 0;
+			}
+			else {
+				actors->sector[e] = updateSector(map, actors->sector[e], x, y);
+			}
+			actors->x[e] = x;
+			actors->y[e] = y;
+		}
+
+		int floor, ceiling;
+		sectorSpan(map, actors->sector[e], z, &floor, &ceiling);
+		fallMove(&z, &actors->velZ[e], floor, ceiling, playerHeight);
+		actors->z[e] = z;
+	}
+}
+
+void moveActors(Engine* engine) {
+	parallelFor(engine->actors.count, actorGrain, moveRange, engine);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+// defines for actor settings
+#define maxActors          16384                   // most actors alive at once
+#define actorRadius        8                       // distance actors keep from walls
+#define actorSpeed         4                       // distance an actor walks each tick
+#define chaseRange         160                     // distance at which actors notice the player
+#define wanderTics         20                      // ticks an actor keeps walking one way
+#define actorGrain         256                     // actors per job when the systems run in parallel
+
+// actor sprite states
+#define ACTOR_IDLE         0                       // standing still
+#define ACTOR_WANDER       1                       // walking in a random direction
+#define ACTOR_CHASE        2                       // walking towards the player
+
+// refers to an actor for as long as it lives, goes stale once the actor is removed
+struct ActorHandle {
+	// slot in the handle table
+	int slot;
+	// generation of the slot when the handle was made
+	int generation;
+};
+
+// every actor as structure of arrays, live actors are packed into entries 0 to count - 1 so
+// systems loop over plain arrays; removing an actor moves the last entry into its place
+struct Actors {
+	// number of live actors
+	int count;
+	// position of the feet
+	int x[maxActors], y[maxActors], z[maxActors];
+	// facing in degrees
+	int angle[maxActors];
+	// movement each tick
+	int velX[maxActors], velY[maxActors], velZ[maxActors];
+	// sector the actor is in, -1 outside every sector
+	int sector[maxActors];
+	// sprite state and ticks left in it
+	int state[maxActors], tics[maxActors];
+	// state of each actor's wander direction generator, so the result does not depend on thread count
+	unsigned int seed[maxActors];
+	// handle slot of each entry
+	int slot[maxActors];
+
+	// entry of each handle slot, -1 for free slots
+	int slotEntry[maxActors];
+	// bumped whenever a slot is freed, so old handles stop matching
+	int slotGeneration[maxActors];
+	// free slots as a linked list, -1 ends it
+	int nextFree[maxActors];
+	int freeHead;
+	// actors spawned since the map was loaded, seeds each new actor's generator
+	unsigned int spawned;
+};
+
+struct Engine;
+
+// remove every actor, called when a map is loaded
+void clearActors(Actors* actors);
+// add an actor standing at x/y on the engine's map, returns a handle with slot -1 if there is no room
+ActorHandle spawnActor(Engine* engine, int x, int y, int angle);
+// remove an actor, false if the handle is stale
+bool removeActor(Actors* actors, ActorHandle handle);
+// entry of a live actor in the arrays, -1 if the handle is stale; entries change when actors are removed
+int actorEntry(const Actors* actors, ActorHandle handle);
+
+// pick each actor's state and velocity: chase the player when near, otherwise wander.
+// runs over the job threads, each actor only reads the player and writes itself
+void thinkActors(Engine* engine);
+// move each actor by its velocity with wall collision, then apply gravity and floors.
+// runs over the job threads, actors do not collide with each other
+void moveActors(Engine* engine);
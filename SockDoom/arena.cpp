@@ -0,0 +1,41 @@
+#include "arena.h"
+
+#include <cstdlib>
+
+void arenaInit(FrameArena* arena, size_t capacity) {
+	arena->base = static_cast<unsigned char*>(malloc(capacity));
+	arena->capacity = (arena->base != nullptr) ? capacity : 0;
+	arena->offset = 0;
+	arena->highWater = 0;
+	arena->overflow = 0;
+}
+
+void arenaFree(FrameArena* arena) {
+	free(arena->base);
+	arena->base = nullptr;
+	arena->capacity = 0;
+	arena->offset = 0;
+}
+
+void* arenaAlloc(FrameArena* arena, size_t size, size_t align) {
+	// round the offset up to the requested alignment (power of two)
+	size_t start = (arena->offset + align - 1) & ~(align - 1);
+
+	if (start + size > arena->capacity) {
+		// remember how far past the end this frame wanted to go
+		if (start + size - arena->capacity > arena->overflow) {
+			arena->overflow = start + size - arena->capacity;
+		}
+		return nullptr;
+	}
+
+	arena->offset = start + size;
+	if (arena->offset > arena->highWater) {
+		arena->highWater = arena->offset;
+	}
+	return arena->base + start;
+}
+
+void arenaReset(FrameArena* arena) {
+	arena->offset = 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+
+// linear allocator for transient data that lives for one frame
+struct FrameArena {
+	// backing memory, allocated once at init
+	unsigned char* base;
+	// size of backing memory in bytes
+	size_t capacity;
+	// offset of the next allocation
+	size_t offset;
+	// largest offset reached since init
+	size_t highWater;
+	// largest number of bytes a single frame asked for but could not get
+	size_t overflow;
+};
+
+// allocate the backing memory, the only heap allocation the arena makes
+void arenaInit(FrameArena* arena, size_t capacity);
+// release the backing memory
+void arenaFree(FrameArena* arena);
+// bump allocate size bytes, returns nullptr if the arena is full
+void* arenaAlloc(FrameArena* arena, size_t size, size_t align);
+// release every allocation at once, called at the end of each frame
+void arenaReset(FrameArena* arena);
+
+// bump allocate an array of count elements of type T
+template <typename T>
+T* arenaAllocArray(FrameArena* arena, int count) {
+	return static_cast<T*>(arenaAlloc(arena, sizeof(T) * count, alignof(T)));
+}
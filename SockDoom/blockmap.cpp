@@ -0,0 +1,260 @@
+#include "blockmap.h"
+
+#include <iostream>
+
+#include "map.h"
+
+// bounding box of a wall
+static void wallBounds(const Wall* wall, int* minX, int* minY, int* maxX, int* maxY) {
+	*minX = (wall->x1 < wall->x2) ? wall->x1 : wall->x2;
+	*maxX = (wall->x1 < wall->x2) ? wall->x2 : wall->x1;
+	*minY = (wall->y1 < wall->y2) ? wall->y1 : wall->y2;
+	*maxY = (wall->y1 < wall->y2) ? wall->y2 : wall->y1;
+}
+
+// cell along one axis, clamped to 0 to cells - 1; in 64 bits since map coordinates are not bounded
+static int cellIndex(int coord, int origin, int size, int cells) {
+	long long cell = (static_cast<long long>(coord) - origin) / size;
+
+	if (cell < 0) {
+		return 0;
+	}
+	if (cell > cells - 1) {
+		return cells - 1;
+	}
+	return static_cast<int>(cell);
+}
+
+// cell range covered by a world space box, clamped to the grid
+static void cellRange(const Blockmap* blockmap, int minX, int minY, int maxX, int maxY, int* cx1, int* cy1, int* cx2, int* cy2) {
+	*cx1 = cellIndex(minX, blockmap->originX, blockmap->size, blockmap->width);
+	*cy1 = cellIndex(minY, blockmap->originY, blockmap->size, blockmap->height);
+	*cx2 = cellIndex(maxX, blockmap->originX, blockmap->size, blockmap->width);
+	*cy2 = cellIndex(maxY, blockmap->originY, blockmap->size, blockmap->height);
+}
+
+bool buildBlockmap(MapData* map) {
+	int w, s, cx, cy, c;
+	Blockmap* blockmap = &map->blockmap;
+	const Wall* walls = map->walls;
+	const Sector* sectors = map->sectors;
+	int numWall = map->numWall;
+	int numSect = map->numSect;
+	int minX = 0, minY = 0, maxX = 0, maxY = 0;
+
+	// bounds of every wall
+	for (w = 0; w < numWall; w++) {
+		int x1, y1, x2, y2;
+		wallBounds(&walls[w], &x1, &y1, &x2, &y2);
+		if (w == 0 || x1 < minX) {
+			minX = x1;
+		}
+		if (w == 0 || y1 < minY) {
+			minY = y1;
+		}
+		if (w == 0 || x2 > maxX) {
+			maxX = x2;
+		}
+		if (w == 0 || y2 > maxY) {
+			maxY = y2;
+		}
+	}
+
+	blockmap->originX = minX;
+	blockmap->originY = minY;
+	blockmap->size = blockSize;
+	// the extent of far apart walls and the cell count can both pass the int range
+	long long extentX = static_cast<long long>(maxX) - minX;
+	long long extentY = static_cast<long long>(maxY) - minY;
+	for (;;) {
+		long long width = extentX / blockmap->size + 1;
+		long long height = extentY / blockmap->size + 1;
+		if (width * height <= maxBlocks) {
+			blockmap->width = static_cast<int>(width);
+			blockmap->height = static_cast<int>(height);
+			break;
+		}
+		blockmap->size *= 2;
+	}
+	int numCells = blockmap->width * blockmap->height;
+
+	// count the walls of each cell, then turn the counts into offsets
+	for (c = 0; c <= numCells; c++) {
+		blockmap->start[c] = 0;
+	}
+	for (w = 0; w < numWall; w++) {
+		int x1, y1, x2, y2, cx1, cy1, cx2, cy2;
+		wallBounds(&walls[w], &x1, &y1, &x2, &y2);
+		cellRange(blockmap, x1, y1, x2, y2, &cx1, &cy1, &cx2, &cy2);
+		for (cy = cy1; cy <= cy2; cy++) {
+			for (cx = cx1; cx <= cx2; cx++) {
+				blockmap->start[cy * blockmap->width + cx + 1]++;
+			}
+		}
+	}
+	for (c = 0; c < numCells; c++) {
+		blockmap->start[c + 1] += blockmap->start[c];
+	}
+	if (blockmap->start[numCells] > maxBlockLinks) {
+		std::cout << "Blockmap needs " << blockmap->start[numCells] << " wall links, the limit is " << maxBlockLinks << std::endl;
+		blockmap->width = 0;
+		blockmap->height = 0;
+		return false;
+	}
+
+	// fill each cell, using its start as a cursor and shifting back afterwards
+	for (w = 0; w < numWall; w++) {
+		int x1, y1, x2, y2, cx1, cy1, cx2, cy2;
+		wallBounds(&walls[w], &x1, &y1, &x2, &y2);
+		cellRange(blockmap, x1, y1, x2, y2, &cx1, &cy1, &cx2, &cy2);
+		for (cy = cy1; cy <= cy2; cy++) {
+			for (cx = cx1; cx <= cx2; cx++) {
+				blockmap->links[blockmap->start[cy * blockmap->width + cx]++] = w;
+			}
+		}
+	}
+	for (c = numCells; c > 0; c--) {
+		blockmap->start[c] = blockmap->start[c - 1];
+	}
+	blockmap->start[0] = 0;
+
+	// walls only block things at the heights of their sector
+	for (w = 0; w < numWall; w++) {
+		blockmap->wallSector[w] = -1;
+	}
+	for (s = 0; s < numSect; s++) {
+		for (w = sectors[s].wallStart; w < sectors[s].wallEnd; w++) {
+			blockmap->wallSector[w] = s;
+		}
+	}
+	return true;
+}
+
+// squared distance from x/y to the wall segment
+static float wallDistanceSq(const Wall* wall, float x, float y) {
+	float dx = wall->x2 - wall->x1;
+	float dy = wall->y2 - wall->y1;
+	float length = dx * dx + dy * dy;
+	float t = 0;
+
+	if (length > 0) {
+		t = ((x - wall->x1) * dx + (y - wall->y1) * dy) / length;
+		if (t < 0) {
+			t = 0;
+		}
+		if (t > 1) {
+			t = 1;
+		}
+	}
+	float nearX = wall->x1 + t * dx - x;
+	float nearY = wall->y1 + t * dy - y;
+	return nearX * nearX + nearY * nearY;
+}
+
+// true if wall w blocks something spanning zLow to zHigh, sectors are solid from z1 to z1 + z2
+static bool wallBlocks(const MapData* map, int w, int zLow, int zHigh) {
+	int s = map->blockmap.wallSector[w];
+	const Sector* sectors = map->sectors;
+
+	if (s < 0) {
+		return true;
+	}
+	return sectors[s].z1 < zHigh && sectors[s].z1 + sectors[s].z2 > zLow;
+}
+
+bool touchesWall(const MapData* map, int x, int y, int radius, int zLow, int zHigh) {
+	int cx, cy, l;
+	int cx1, cy1, cx2, cy2;
+	const Blockmap* blockmap = &map->blockmap;
+
+	if (blockmap->width == 0) {
+		return false;
+	}
+	// a wall in several of these cells is simply tested again, which keeps queries reentrant
+	cellRange(blockmap, x - radius, y - radius, x + radius, y + radius, &cx1, &cy1, &cx2, &cy2);
+
+	for (cy = cy1; cy <= cy2; cy++) {
+		for (cx = cx1; cx <= cx2; cx++) {
+			int cell = cy * blockmap->width + cx;
+			for (l = blockmap->start[cell]; l < blockmap->start[cell + 1]; l++) {
+				int w = blockmap->links[l];
+				if (wallDistanceSq(&map->walls[w], x, y) < radius * radius && wallBlocks(map, w, zLow, zHigh)) {
+					return true;
+				}
+			}
+		}
+	}
+	return false;
+}
+
+// true if the path from x1/y1 to x2/y2 crosses the wall from one side to the other
+static bool crossesWall(const Wall* wall, int x1, int y1, int x2, int y2) {
+	long long wx = static_cast<long long>(wall->x2) - wall->x1, wy = static_cast<long long>(wall->y2) - wall->y1;
+	long long px = static_cast<long long>(x2) - x1, py = static_cast<long long>(y2) - y1;
+	long long side1 = wx * (static_cast<long long>(y1) - wall->y1) - wy * (static_cast<long long>(x1) - wall->x1);
+	long long side2 = wx * (static_cast<long long>(y2) - wall->y1) - wy * (static_cast<long long>(x2) - wall->x1);
+	long long end1 = px * (static_cast<long long>(wall->y1) - y1) - py * (static_cast<long long>(wall->x1) - x1);
+	long long end2 = px * (static_cast<long long>(wall->y2) - y1) - py * (static_cast<long long>(wall->x2) - x1);
+
+	return ((side1 < 0 && side2 > 0) || (side1 > 0 && side2 < 0)) && ((end1 < 0 && end2 > 0) || (end1 > 0 && end2 < 0));
+}
+
+// true if a circle that already overlaps walls may move from x/y to nx/ny: it gets no closer to any
+// wall it touches at the end, and passes through none of them
+static bool backsOut(const MapData* map, int x, int y, int nx, int ny, int radius, int zLow, int zHigh) {
+	int cx, cy, l;
+	int cx1, cy1, cx2, cy2;
+	const Blockmap* blockmap = &map->blockmap;
+
+	if (blockmap->width == 0) {
+		return true;
+	}
+	cellRange(blockmap, ((x < nx) ? x : nx) - radius, ((y < ny) ? y : ny) - radius, ((x > nx) ? x : nx) + radius, ((y > ny) ? y : ny) + radius, &cx1, &cy1, &cx2, &cy2);
+
+	for (cy = cy1; cy <= cy2; cy++) {
+		for (cx = cx1; cx <= cx2; cx++) {
+			int cell = cy * blockmap->width + cx;
+			for (l = blockmap->start[cell]; l < blockmap->start[cell + 1]; l++) {
+				int w = blockmap->links[l];
+				const Wall* wall = &map->walls[w];
+				if (!wallBlocks(map, w, zLow, zHigh)) {
+					continue;
+				}
+				float after = wallDistanceSq(wall, nx, ny);
+				if ((after < radius * radius && after < wallDistanceSq(wall, x, y)) || crossesWall(wall, x, y, nx, ny)) {
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+void slideMove(const MapData* map, int* x, int* y, int dx, int dy, int radius, int zLow, int zHigh) {
+	// something that already overlaps a wall, after spawning there or changing height, may back out but not go deeper
+	if (touchesWall(map, *x, *y, radius, zLow, zHigh)) {
+		if (backsOut(map, *x, *y, *x + dx, *y + dy, radius, zLow, zHigh)) {
+			*x += dx;
+			*y += dy;
+		}
+		else if (dx != 0 && backsOut(map, *x, *y, *x + dx, *y, radius, zLow, zHigh)) {
+			*x += dx;
+		}
+		else if (dy != 0 && backsOut(map, *x, *y, *x, *y + dy, radius, zLow, zHigh)) {
+			*y += dy;
+		}
+		return;
+	}
+
+	if (!touchesWall(map, *x + dx, *y + dy, radius, zLow, zHigh)) {
+		*x += dx;
+		*y += dy;
+	}
+	// slide along the wall on the axis that is still free
+	else if (dx != 0 && !touchesWall(map, *x + dx, *y, radius, zLow, zHigh)) {
+		*x += dx;
+	}
+	else if (dy != 0 && !touchesWall(map, *x, *y + dy, radius, zLow, zHigh)) {
+		*y += dy;
+	}
+}
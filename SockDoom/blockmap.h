@@ -0,0 +1,34 @@
+#pragma once
+
+#include "types.h"
+
+// defines for collision settings
+#define blockSize          64                      // smallest blockmap cell size in world units
+#define maxBlocks          16384                   // most cells in the blockmap
+#define maxBlockLinks      32768                   // most wall references over all cells
+#define playerRadius       8                       // distance the player keeps from walls
+
+// uniform grid over the map, each cell lists the walls whose bounding box touches it
+struct Blockmap {
+	// world position of the bottom left corner of cell 0
+	int originX, originY;
+	// cell size in world units, doubled until the map fits in maxBlocks
+	int size;
+	// number of cells across and up
+	int width, height;
+	// walls of cell c are links[start[c]] to links[start[c + 1] - 1]
+	int start[maxBlocks + 1];
+	int links[maxBlockLinks];
+	// sector each wall belongs to, -1 for walls outside every sector
+	int wallSector[maxWall];
+};
+
+struct MapData;
+
+// build the blockmap of a map from its walls, called when the map is built
+bool buildBlockmap(MapData* map);
+// true if a circle of radius at x/y touches any wall whose sector overlaps the heights zLow to zHigh
+bool touchesWall(const MapData* map, int x, int y, int radius, int zLow, int zHigh);
+// move a circle spanning zLow to zHigh by dx/dy, sliding along walls on whichever axis is still free;
+// a circle that already overlaps a wall can only move away from it
+void slideMove(const MapData* map, int* x, int* y, int dx, int dy, int radius, int zLow, int zHigh);
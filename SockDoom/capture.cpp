@@ -0,0 +1,201 @@
+#include "capture.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "render.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#define dup _dup
+#define dup2 _dup2
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
+
+int captureFrameSize(int format) {
+	return (format == CAPTURE_RGB) ? SW * SH * 3 : SW * SH + 2 * (SW / 2) * (SH / 2);
+}
+
+// fill the y, u, v and rgb of every palette color
+static void buildPalette(Capture* capture) {
+	int c;
+	unsigned char rgb[3];
+
+	for (c = 0; c < 256; c++) {
+		paletteColor(c, rgb);
+		capture->paletteRGB[c][0] = rgb[0];
+		capture->paletteRGB[c][1] = rgb[1];
+		capture->paletteRGB[c][2] = rgb[2];
+		capture->paletteY[c] = static_cast<unsigned char>(16 + (65.481 * rgb[0] + 128.553 * rgb[1] + 24.966 * rgb[2]) / 255 + 0.5);
+		capture->paletteU[c] = static_cast<unsigned char>(128 + (-37.797 * rgb[0] - 74.203 * rgb[1] + 112.0 * rgb[2]) / 255 + 0.5);
+		capture->paletteV[c] = static_cast<unsigned char>(128 + (112.0 * rgb[0] - 93.786 * rgb[1] - 18.214 * rgb[2]) / 255 + 0.5);
+	}
+}
+
+// convert a palette frame to planar y, u, v with each chroma sample the average of a 2x2 block,
+// flipping it so the top row comes first
+static void convertY4M(const Capture* capture, const unsigned char* frame, unsigned char* out) {
+	int x, y;
+	unsigned char* planeY = out;
+	unsigned char* planeU = out + SW * SH;
+	unsigned char* planeV = planeU + (SW / 2) * (SH / 2);
+
+	for (y = 0; y < SH; y++) {
+		const unsigned char* row = &frame[(SH - 1 - y) * SW];
+		unsigned char* outRow = &planeY[y * SW];
+		for (x = 0; x < SW; x++) {
+			outRow[x] = capture->paletteY[row[x]];
+		}
+	}
+	for (y = 0; y < SH / 2; y++) {
+		const unsigned char* top = &frame[(SH - 1 - 2 * y) * SW];
+		const unsigned char* bottom = top - SW;
+		for (x = 0; x < SW / 2; x++) {
+			int a = top[2 * x], b = top[2 * x + 1], c = bottom[2 * x], d = bottom[2 * x + 1];
+			planeU[y * (SW / 2) + x] = (capture->paletteU[a] + capture->paletteU[b] + capture->paletteU[c] + capture->paletteU[d] + 2) >> 2;
+			planeV[y * (SW / 2) + x] = (capture->paletteV[a] + capture->paletteV[b] + capture->paletteV[c] + capture->paletteV[d] + 2) >> 2;
+		}
+	}
+}
+
+// convert a palette frame to rgb24, top row first
+static void convertRGB(const Capture* capture, const unsigned char* frame, unsigned char* out) {
+	int x, y;
+
+	for (y = 0; y < SH; y++) {
+		const unsigned char* row = &frame[(SH - 1 - y) * SW];
+		unsigned char* outRow = &out[y * SW * 3];
+		for (x = 0; x < SW; x++) {
+			const unsigned char* rgb = capture->paletteRGB[row[x]];
+			outRow[x * 3 + 0] = rgb[0];
+			outRow[x * 3 + 1] = rgb[1];
+			outRow[x * 3 + 2] = rgb[2];
+		}
+	}
+}
+
+static void writerLoop(Capture* capture) {
+	int size = captureFrameSize(capture->format);
+
+	for (;;) {
+		int slot;
+		{
+			std::unique_lock<std::mutex> guard(capture->lock);
+			capture->cv.wait(guard, [capture] { return capture->head < capture->tail || capture->quit; });
+			if (capture->head == capture->tail) {
+				return;
+			}
+			slot = static_cast<int>(capture->head % captureBuffers);
+		}
+
+		if (capture->format == CAPTURE_RGB) {
+			convertRGB(capture, capture->frames[slot], capture->converted.get());
+		}
+		else {
+			convertY4M(capture, capture->frames[slot], capture->converted.get());
+		}
+		// the buffer is free again before the write, which can block on the pipe
+		{
+			std::lock_guard<std::mutex> guard(capture->lock);
+			capture->head++;
+		}
+		capture->cv.notify_all();
+
+		if (capture->failed) {
+			continue;
+		}
+		if ((capture->format == CAPTURE_Y4M && fputs("FRAME\n", capture->file) == EOF) ||
+			fwrite(capture->converted.get(), 1, size, capture->file) != static_cast<size_t>(size)) {
+			capture->failed = true;
+			continue;
+		}
+		capture->written++;
+	}
+}
+
+bool captureOpen(Capture* capture, const char* path, int format, bool dropWhenFull) {
+	capture->file = nullptr;
+	if (strcmp(path, "-") == 0) {
+		// the stream takes over stdout, everything the program prints goes to stderr instead
+		fflush(stdout);
+		int fd = dup(fileno(stdout));
+		if (fd >= 0) {
+			dup2(fileno(stderr), fileno(stdout));
+#ifdef _WIN32
+			_setmode(fd, _O_BINARY);
+#endif
+			capture->file = fdopen(fd, "wb");
+		}
+	}
+	else {
+		capture->file = fopen(path, "wb");
+	}
+	if (capture->file == nullptr) {
+		std::cout << "Failed to open " << path << " for capture" << std::endl;
+		return false;
+	}
+
+	capture->format = format;
+	capture->dropWhenFull = dropWhenFull;
+	capture->head = 0;
+	capture->tail = 0;
+	capture->quit = false;
+	capture->written = 0;
+	capture->dropped = 0;
+	capture->failed = false;
+	buildPalette(capture);
+	capture->converted.reset(new unsigned char[captureFrameSize(format)]);
+
+	if (format == CAPTURE_Y4M) {
+		// C420jpeg puts each chroma sample in the middle of its 2x2 block, as it is averaged
+		fprintf(capture->file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", SW, SH, captureRate);
+	}
+	capture->writer = std::thread(writerLoop, capture);
+	return true;
+}
+
+bool captureFrame(Capture* capture, const unsigned char* frame) {
+	if (capture->file == nullptr) {
+		return false;
+	}
+	{
+		std::unique_lock<std::mutex> guard(capture->lock);
+		if (capture->tail - capture->head == captureBuffers) {
+			if (capture->dropWhenFull) {
+				capture->dropped++;
+				return false;
+			}
+			capture->cv.wait(guard, [capture] { return capture->tail - capture->head < captureBuffers; });
+		}
+	}
+	// only this thread adds frames, so the slot stays free while it is filled
+	memcpy(capture->frames[capture->tail % captureBuffers], frame, SW * SH);
+	{
+		std::lock_guard<std::mutex> guard(capture->lock);
+		capture->tail++;
+	}
+	capture->cv.notify_all();
+	return true;
+}
+
+bool captureClose(Capture* capture) {
+	if (capture->file == nullptr) {
+		return true;
+	}
+	{
+		std::lock_guard<std::mutex> guard(capture->lock);
+		capture->quit = true;
+	}
+	capture->cv.notify_all();
+	capture->writer.join();
+
+	if (fclose(capture->file) != 0) {
+		capture->failed = true;
+	}
+	capture->file = nullptr;
+	capture->converted.reset();
+	return !capture->failed;
+}
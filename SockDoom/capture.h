@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "types.h"
+
+// defines for capture settings
+#define captureBuffers     8                       // frames waiting for the writer thread
+#define captureRate        20                      // frames per second written in the y4m header
+
+// defines for capture formats
+#define CAPTURE_Y4M        0                       // yuv4mpeg2 with 4:2:0 chroma, which ffmpeg reads from a pipe
+#define CAPTURE_RGB        1                       // headerless rgb24, top row first
+
+// writes frames to a file or stdout on its own thread. the caller only copies each palette frame
+// into a free buffer; the writer converts and writes it, so the caller never waits on the disk
+// or the pipe unless it asks to wait for a buffer
+struct Capture {
+	FILE* file;
+	int format;
+	// drop a frame when every buffer is waiting for the writer, instead of waiting for one
+	bool dropWhenFull;
+	std::thread writer;
+	std::mutex lock;
+	std::condition_variable cv;
+	// palette frames with row 0 the bottom, frames[head % captureBuffers] to
+	// frames[(tail - 1) % captureBuffers] wait for the writer
+	unsigned char frames[captureBuffers][SW * SH];
+	// total frames taken by the writer and given by the caller
+	long long head, tail;
+	bool quit;
+	// frames written and dropped, and whether a write failed
+	long long written, dropped;
+	bool failed;
+	// luma and chroma of every palette color, studio range bt.601
+	unsigned char paletteY[256], paletteU[256], paletteV[256];
+	unsigned char paletteRGB[256][3];
+	// one converted frame, only touched by the writer
+	std::unique_ptr<unsigned char[]> converted;
+};
+
+// start capturing to path in a CAPTURE_ format, "-" writes to stdout and moves the program's own
+// output to stderr so it stays out of the stream; false if the file cannot be opened
+bool captureOpen(Capture* capture, const char* path, int format, bool dropWhenFull);
+// queue a SW * SH palette frame, false if it was dropped or capture is not open
+bool captureFrame(Capture* capture, const unsigned char* frame);
+// write every queued frame, stop the writer and close the file; false if any write failed
+bool captureClose(Capture* capture);
+// bytes one frame takes in the stream, without the y4m frame header
+int captureFrameSize(int format);
@@ -0,0 +1,172 @@
+#include "demo.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "actor.h"
+
+// bit of each key in a packed tick
+#define DEMO_W             0x001
+#define DEMO_A             0x002
+#define DEMO_S             0x004
+#define DEMO_D             0x008
+#define DEMO_STRAFE_L      0x010
+#define DEMO_STRAFE_R      0x020
+#define DEMO_MLOOK         0x040
+#define DEMO_JUMP          0x080
+#define DEMO_FLY           0x100
+
+unsigned short packKeys(const Keys* keys) {
+	unsigned short mask = 0;
+
+	mask |= keys->w ? DEMO_W : 0;
+	mask |= keys->a ? DEMO_A : 0;
+	mask |= keys->s ? DEMO_S : 0;
+	mask |= keys->d ? DEMO_D : 0;
+	mask |= keys->strafeL ? DEMO_STRAFE_L : 0;
+	mask |= keys->strafeR ? DEMO_STRAFE_R : 0;
+	mask |= keys->mlook ? DEMO_MLOOK : 0;
+	mask |= keys->jump ? DEMO_JUMP : 0;
+	mask |= keys->fly ? DEMO_FLY : 0;
+	return mask;
+}
+
+void unpackKeys(unsigned short mask, Keys* keys) {
+	keys->w = (mask & DEMO_W) != 0;
+	keys->a = (mask & DEMO_A) != 0;
+	keys->s = (mask & DEMO_S) != 0;
+	keys->d = (mask & DEMO_D) != 0;
+	keys->strafeL = (mask & DEMO_STRAFE_L) != 0;
+	keys->strafeR = (mask & DEMO_STRAFE_R) != 0;
+	keys->mlook = (mask & DEMO_MLOOK) != 0;
+	keys->jump = (mask & DEMO_JUMP) != 0;
+	keys->fly = (mask & DEMO_FLY) != 0;
+}
+
+bool demoBegin(Demo* demo, const Engine* engine, const char* mapPath) {
+	if (mapPath == nullptr) {
+		mapPath = "";
+	}
+	if (strlen(mapPath) >= maxDemoMapPath) {
+		std::cout << "Map path " << mapPath << " is too long for a demo" << std::endl;
+		return false;
+	}
+	strcpy(demo->map, mapPath);
+	demo->start[0] = engine->player.x;
+	demo->start[1] = engine->player.y;
+	demo->start[2] = engine->player.z;
+	demo->start[3] = engine->player.angle;
+	demo->start[4] = engine->player.look;
+	demo->numTicks = 0;
+	return true;
+}
+
+bool demoRecordTick(Demo* demo, const Keys* keys) {
+	if (demo->numTicks >= maxDemoTicks) {
+		return false;
+	}
+	demo->ticks[demo->numTicks++] = packKeys(keys);
+	return true;
+}
+
+// write the low bytes of a value, least significant first
+static void writeBytes(FILE* file, unsigned int value, int bytes) {
+	int i;
+
+	for (i = 0; i < bytes; i++) {
+		fputc((value >> (i * 8)) & 0xff, file);
+	}
+}
+
+// read a little endian value, false at the end of the file
+static bool readBytes(FILE* file, unsigned int* value, int bytes) {
+	int i;
+
+	*value = 0;
+	for (i = 0; i < bytes; i++) {
+		int c = fgetc(file);
+		if (c == EOF) {
+			return false;
+		}
+		*value |= static_cast<unsigned int>(c) << (i * 8);
+	}
+	return true;
+}
+
+bool demoWrite(const Demo* demo, const char* path) {
+	int i;
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	fputs("SDDM", file);
+	writeBytes(file, demoVersion, 1);
+	int length = static_cast<int>(strlen(demo->map));
+	writeBytes(file, length, 2);
+	fwrite(demo->map, 1, length, file);
+	for (i = 0; i < 5; i++) {
+		writeBytes(file, static_cast<unsigned int>(demo->start[i]), 4);
+	}
+	writeBytes(file, demo->numTicks, 4);
+	for (i = 0; i < demo->numTicks; i++) {
+		writeBytes(file, demo->ticks[i], 2);
+	}
+
+	bool ok = ferror(file) == 0;
+	fclose(file);
+	return ok;
+}
+
+bool demoRead(Demo* demo, const char* path) {
+	char magic[4];
+	unsigned int value, length, ticks;
+	int i;
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) {
+		std::cout << "Failed to open demo " << path << std::endl;
+		return false;
+	}
+
+	bool ok = fread(magic, 1, 4, file) == 4 && memcmp(magic, "SDDM", 4) == 0;
+	ok = ok && readBytes(file, &value, 1) && value == demoVersion;
+	ok = ok && readBytes(file, &length, 2) && length < maxDemoMapPath && fread(demo->map, 1, length, file) == length;
+	if (ok) {
+		demo->map[length] = '\0';
+	}
+	for (i = 0; i < 5 && ok; i++) {
+		ok = readBytes(file, &value, 4);
+		demo->start[i] = static_cast<int>(value);
+	}
+	ok = ok && readBytes(file, &ticks, 4) && ticks <= maxDemoTicks;
+	for (i = 0; ok && i < static_cast<int>(ticks); i++) {
+		ok = readBytes(file, &value, 2);
+		demo->ticks[i] = static_cast<unsigned short>(value);
+	}
+	fclose(file);
+
+	if (!ok) {
+		std::cout << "Demo " << path << " is not a version " << demoVersion << " demo or is cut short" << std::endl;
+		demo->numTicks = 0;
+		return false;
+	}
+	demo->numTicks = static_cast<int>(ticks);
+	return true;
+}
+
+bool demoStart(Engine* engine, const Demo* demo) {
+	std::shared_ptr<const MapData> map = (demo->map[0] != '\0') ? loadMapFile(demo->map) : builtInMap();
+	if (!setMap(engine, map)) {
+		return false;
+	}
+	setPose(engine, demo->start);
+	return true;
+}
+
+void demoTick(Engine* engine, const Demo* demo, int tick) {
+	unpackKeys(demo->ticks[tick], &engine->keys);
+	movePlayer(engine);
+	thinkActors(engine);
+	moveActors(engine);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "engine.h"
+
+// defines for demo settings
+#define maxDemoTicks       72000                   // longest demo, one hour at 20 ticks/second
+#define maxDemoMapPath     256                     // longest map path stored in a demo, with its terminator
+#define demoVersion        1                       // format version written after the magic
+
+// a recorded session: the map and starting pose, then the keys of every tick.
+// on disk it is "SDDM", the version byte, the map path as a 16 bit length and its bytes
+// (empty for the built-in map), the pose as five 32 bit ints, the tick count as a 32 bit int and
+// one 16 bit key mask per tick, all little endian
+struct Demo {
+	char map[maxDemoMapPath];
+	// x, y, z, angle, look of the player on the first tick
+	int start[5];
+	int numTicks;
+	unsigned short ticks[maxDemoTicks];
+};
+
+// pack the keys of a tick into a bit mask and back
+unsigned short packKeys(const Keys* keys);
+void unpackKeys(unsigned short mask, Keys* keys);
+
+// start recording from the engine's player pose on a map, nullptr for the built-in map
+bool demoBegin(Demo* demo, const Engine* engine, const char* mapPath);
+// add the keys of the tick that is about to run, false once the demo is full
+bool demoRecordTick(Demo* demo, const Keys* keys);
+bool demoWrite(const Demo* demo, const char* path);
+bool demoRead(Demo* demo, const char* path);
+
+// switch the engine to the demo's map, clearing its actors, and put the player at its start
+bool demoStart(Engine* engine, const Demo* demo);
+// run one tick of the demo on the engine: its keys, then the player and actor systems
+void demoTick(Engine* engine, const Demo* demo, int tick);
@@ -0,0 +1,30 @@
+#include "detail.h"
+
+#include "render.h"
+
+void detailInit(DetailControl* control, int64_t budget, int reduced) {
+	control->budget = budget;
+	control->reduced = reduced;
+	control->columns = COLUMNS_FULL;
+	control->total = 0;
+	control->frames = 0;
+}
+
+int detailUpdate(DetailControl* control, int64_t renderTime) {
+	control->total += renderTime;
+	control->frames++;
+	if (control->frames < detailFrames) {
+		return control->columns;
+	}
+
+	int64_t average = control->total / control->frames;
+	if (control->columns == COLUMNS_FULL && average * 100 > control->budget * detailDropAt) {
+		control->columns = control->reduced;
+	}
+	else if (control->columns != COLUMNS_FULL && average * 100 < control->budget * detailRaiseAt) {
+		control->columns = COLUMNS_FULL;
+	}
+	control->total = 0;
+	control->frames = 0;
+	return control->columns;
+}
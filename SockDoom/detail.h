@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// defines for detail controller settings
+#define detailFrames       8                       // frames averaged before each decision
+#define detailDropAt       90                      // percent of the budget above which detail drops
+#define detailRaiseAt      40                      // percent of the budget below which full detail comes back
+
+// dynamic detail: picks the column mode of each frame from how long the last frames took to render.
+// it drops to a reduced mode when they average over the budget and returns to full detail once the
+// reduced frames average well under half of it, so halving the columns does not bounce straight back
+struct DetailControl {
+	// render time allowed per frame in nanoseconds
+	int64_t budget;
+	// COLUMNS_LOW or COLUMNS_INTERLACED, used while over budget
+	int reduced;
+	// column mode of the next frame
+	int columns;
+	// render time of the frames since the last decision
+	int64_t total;
+	int frames;
+};
+
+// start at full detail
+void detailInit(DetailControl* control, int64_t budget, int reduced);
+// add the render time of a frame in nanoseconds and return the column mode for the next one
+int detailUpdate(DetailControl* control, int64_t renderTime);
@@ -0,0 +1,166 @@
+#include "engine.h"
+
+#include <cmath>
+
+#include "blockmap.h"
+#include "physics.h"
+#include "sectormap.h"
+
+// build the sin/cos tables in degrees
+static std::shared_ptr<const Rotation> buildRotation() {
+	std::shared_ptr<Rotation> rot = std::make_shared<Rotation>();
+	int x;
+
+	for (x = 0; x < 360; x++) {
+		rot->cos[x] = cos(x / 180.0 * PI);
+		rot->sin[x] = sin(x / 180.0 * PI);
+	}
+	return rot;
+}
+
+// sin/cos tables, built once and shared by every engine
+static std::shared_ptr<const Rotation> sharedRotation() {
+	// function statics are initialized once even with several threads
+	static std::shared_ptr<const Rotation> rot = buildRotation();
+	return rot;
+}
+
+Engine* createEngine() {
+	// value initialized, so every array starts zeroed
+	Engine* engine = new Engine();
+	initView(&engine->view);
+	init(engine);
+	return engine;
+}
+
+void destroyEngine(Engine* engine) {
+	if (engine == nullptr) {
+		return;
+	}
+	freeView(&engine->view);
+	delete engine;
+}
+
+void movePlayer(Engine* engine) {
+	Player* player = &engine->player;
+	const Keys* keys = &engine->keys;
+	const MapData* map = engine->map.get();
+
+	// move up, down, left, right
+	if (keys->a == 1 && keys->mlook == 0) {
+		player->angle -= 4;
+
+		if (player->angle < 0) {
+			player->angle += 360;
+		}
+	}
+	if (keys->d == 1 && keys->mlook == 0) {
+		player->angle += 4;
+
+		if (player->angle > 359) {
+			player->angle -= 360;
+		}
+	}
+
+	int deltaX = engine->rot->sin[player->angle] * 10.0;
+	int deltaY = engine->rot->cos[player->angle] * 10.0;
+	// total movement this frame, applied once so walls can block it
+	int moveX = 0;
+	int moveY = 0;
+
+	if (keys->w == 1 && keys->mlook == 0) {
+		moveX += deltaX;
+		moveY += deltaY;
+	}
+	if (keys->s == 1 && keys->mlook == 0) {
+		moveX -= deltaX;
+		moveY -= deltaY;
+	}
+
+	// strafe left, right
+	if (keys->strafeL == 1) {
+		moveX -= deltaY;
+		moveY += deltaX;
+	}
+	if (keys->strafeR == 1) {
+		moveX += deltaY;
+		moveY -= deltaX;
+	}
+
+	// moves are at most 15 units, under twice playerRadius, so the player cannot step through a wall;
+	// walls of sectors low enough to step onto or high enough to walk under do not block
+	int feet = player->z - eyeHeight;
+	if (moveX != 0 || moveY != 0) {
+		slideMove(map, &player->x, &player->y, moveX, moveY, playerRadius, feet + stepHeight, feet + playerHeight);
+		player->sector = updateSector(map, player->sector, player->x, player->y);
+	}
+
+	// fall, land, step up and bump the ceiling of the sector the player is in
+	if (keys->fly == 0) {
+		int floor, ceiling;
+		sectorSpan(map, player->sector, feet, &floor, &ceiling);
+		if (keys->jump == 1 && feet <= floor) {
+			player->velZ = jumpSpeed;
+		}
+		fallMove(&feet, &player->velZ, floor, ceiling, playerHeight);
+		player->z = feet + eyeHeight;
+	}
+	else {
+		player->velZ = 0;
+	}
+
+	// move up, down, look up, look down
+	if (keys->a == 1 && keys->mlook == 1) {
+		player->look -= 1;
+	}
+	if (keys->d == 1 && keys->mlook == 1) {
+		player->look += 1;
+	}
+	if (keys->w == 1 && keys->mlook == 1 && keys->fly == 1) {
+		player->z -= 4;
+	}
+	if (keys->s == 1 && keys->mlook == 1 && keys->fly == 1) {
+		player->z += 4;
+	}
+}
+
+void init(Engine* engine) {
+	engine->rot = sharedRotation();
+
+	setMap(engine, builtInMap());
+}
+
+bool setMap(Engine* engine, std::shared_ptr<const MapData> map) {
+	if (map == nullptr) {
+		return false;
+	}
+	engine->map = map;
+	resetSectorOrder(&engine->view, map->numSect);
+	clearActors(&engine->actors);
+
+	// initialize player
+	setPose(engine, engine->map->start);
+	return true;
+}
+
+bool loadMapData(Engine* engine, const int* sectorData, int sectorCount, const int* wallData, int wallCount, const int start[5]) {
+	return setMap(engine, buildMap(sectorData, sectorCount, wallData, wallCount, start));
+}
+
+bool loadMap(Engine* engine, const char* path) {
+	// a bad file leaves the current map alone
+	return setMap(engine, loadMapFile(path));
+}
+
+// place the player at x, y, z, angle, look
+void setPose(Engine* engine, const int pose[5]) {
+	Player* player = &engine->player;
+
+	player->x = pose[0];
+	player->y = pose[1];
+	player->z = pose[2];
+	player->angle = ((pose[3] % 360) + 360) % 360;
+	player->look = pose[4];
+	player->sector = findSector(engine->map.get(), player->x, player->y);
+	player->velZ = 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <memory>
+
+#include "actor.h"
+#include "map.h"
+#include "render.h"
+#include "stats.h"
+#include "types.h"
+
+// everything one game needs: its map, player, actors and renderer. engines share nothing they
+// write, so any number can run at once on different threads; the trig tables and maps they read
+// are shared between them and freed along with the last engine using them
+struct Engine {
+	// sin/cos tables, the same for every engine
+	std::shared_ptr<const Rotation> rot;
+	// map being played
+	std::shared_ptr<const MapData> map;
+	Time frameTime;
+	Keys keys;
+	Player player;
+	Actors actors;
+
+	// frame, depth and sector state of the player's camera
+	View view;
+};
+
+// allocate an engine on the built-in map, the engine alone is several megabytes
+Engine* createEngine();
+// free an engine and its frame arena, dropping its share of the map and trig tables
+void destroyEngine(Engine* engine);
+
+// apply one frame of keyboard movement to the player
+void movePlayer(Engine* engine);
+// load the built-in map and reset the player
+void init(Engine* engine);
+// play on a map, which can be shared with other engines: clears the actors and puts the player
+// at the map's start, false and unchanged if map is nullptr
+bool setMap(Engine* engine, std::shared_ptr<const MapData> map);
+// replace the current map with sectors and walls in the same layout as loadSectors and loadWalls,
+// start holds the player x, y, z, angle, look
+bool loadMapData(Engine* engine, const int* sectorData, int sectorCount, const int* wallData, int wallCount, const int start[5]);
+// replace the current map with a .map file, see maps/default.map for the format
+bool loadMap(Engine* engine, const char* path);
+// place the player at x, y, z, angle, look
+void setPose(Engine* engine, const int pose[5]);
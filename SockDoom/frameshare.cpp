@@ -0,0 +1,220 @@
+#include "frameshare.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "render.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// readers give up on a frame after this many torn reads in a row
+#define shareReadTries     8
+
+// bytes of the header rounded up to a cache line, so frames start aligned
+static size_t frameOffset() {
+	return (sizeof(ShareHeader) + 63) / 64 * 64;
+}
+
+static size_t shareSize() {
+	return frameOffset() + static_cast<size_t>(shareSlots) * SW * SH;
+}
+
+static unsigned char* slotPixels(const FrameShare* share, int slot) {
+	return reinterpret_cast<unsigned char*>(share->header) + share->header->frameOffset + static_cast<size_t>(slot) * SW * SH;
+}
+
+// shared memory names start with a single slash
+static void shareName(FrameShare* share, const char* name) {
+	snprintf(share->name, sizeof(share->name), "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+#ifdef _WIN32
+
+bool frameShareCreate(FrameShare* share, const char* name) {
+	share->header = nullptr;
+	std::cout << "Shared frame export is not supported on windows, not creating " << name << std::endl;
+	return false;
+}
+
+bool frameShareOpen(FrameShare* share, const char* name) {
+	share->header = nullptr;
+	std::cout << "Shared frame export is not supported on windows, not opening " << name << std::endl;
+	return false;
+}
+
+void frameShareClose(FrameShare* share) {
+	share->header = nullptr;
+}
+
+#else
+
+bool frameShareCreate(FrameShare* share, const char* name) {
+	int i, c;
+
+	share->header = nullptr;
+	share->size = shareSize();
+	share->published = 0;
+	share->owner = true;
+	shareName(share, name);
+
+	// a ring left behind by a crashed game is replaced, its readers keep their old mapping
+	shm_unlink(share->name);
+	int fd = shm_open(share->name, O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0) {
+		std::cout << "Failed to create shared memory " << share->name << std::endl;
+		return false;
+	}
+	if (ftruncate(fd, share->size) != 0) {
+		std::cout << "Failed to size shared memory " << share->name << std::endl;
+		close(fd);
+		shm_unlink(share->name);
+		return false;
+	}
+	void* memory = mmap(nullptr, share->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	// the mapping stays valid without the descriptor
+	close(fd);
+	if (memory == MAP_FAILED) {
+		std::cout << "Failed to map shared memory " << share->name << std::endl;
+		shm_unlink(share->name);
+		return false;
+	}
+
+	// new shared memory is zeroed, so every seq starts even and latest at 0
+	ShareHeader* header = static_cast<ShareHeader*>(memory);
+	header->version = shareVersion;
+	header->width = SW;
+	header->height = SH;
+	header->slots = shareSlots;
+	header->frameOffset = static_cast<uint32_t>(frameOffset());
+	for (c = 0; c < 256; c++) {
+		paletteColor(c, header->palette[c]);
+	}
+	for (i = 0; i < shareSlots; i++) {
+		header->slot[i].seq.store(0, std::memory_order_relaxed);
+	}
+	header->latest.store(0, std::memory_order_relaxed);
+	// readers check the magic last, once the rest of the header is filled in
+	std::atomic_thread_fence(std::memory_order_release);
+	header->magic = shareMagic;
+	share->header = header;
+	return true;
+}
+
+bool frameShareOpen(FrameShare* share, const char* name) {
+	struct stat info;
+
+	share->header = nullptr;
+	share->published = 0;
+	share->owner = false;
+	shareName(share, name);
+
+	int fd = shm_open(share->name, O_RDONLY, 0);
+	if (fd < 0) {
+		std::cout << "Failed to open shared memory " << share->name << std::endl;
+		return false;
+	}
+	if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(ShareHeader)) {
+		std::cout << "Shared memory " << share->name << " is too small for a frame ring" << std::endl;
+		close(fd);
+		return false;
+	}
+	share->size = info.st_size;
+	void* memory = mmap(nullptr, share->size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (memory == MAP_FAILED) {
+		std::cout << "Failed to map shared memory " << share->name << std::endl;
+		return false;
+	}
+
+	const ShareHeader* header = static_cast<const ShareHeader*>(memory);
+	if (header->magic != shareMagic || header->version != shareVersion || header->width != SW || header->height != SH ||
+		header->slots != shareSlots || share->size < shareSize()) {
+		std::cout << "Shared memory " << share->name << " is not a frame ring of this version" << std::endl;
+		munmap(memory, share->size);
+		return false;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	share->header = const_cast<ShareHeader*>(header);
+	return true;
+}
+
+void frameShareClose(FrameShare* share) {
+	if (share->header == nullptr) {
+		return;
+	}
+	munmap(share->header, share->size);
+	if (share->owner) {
+		shm_unlink(share->name);
+	}
+	share->header = nullptr;
+}
+
+#endif
+
+void frameSharePublish(FrameShare* share, const unsigned char* frame) {
+	if (share->header == nullptr || !share->owner) {
+		return;
+	}
+	uint64_t number = share->published + 1;
+	ShareSlot* slot = &share->header->slot[(number - 1) % shareSlots];
+	uint32_t seq = slot->seq.load(std::memory_order_relaxed);
+
+	// odd while the pixels change
+	slot->seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(slotPixels(share, static_cast<int>((number - 1) % shareSlots)), frame, SW * SH);
+	slot->frame = number;
+	slot->time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	slot->seq.store(seq + 2, std::memory_order_release);
+
+	share->header->latest.store(number, std::memory_order_release);
+	share->published = number;
+}
+
+const unsigned char* frameShareBegin(const FrameShare* share, ShareToken* token) {
+	if (share->header == nullptr) {
+		return nullptr;
+	}
+	uint64_t latest = share->header->latest.load(std::memory_order_acquire);
+	if (latest == 0) {
+		return nullptr;
+	}
+	token->slot = static_cast<int>((latest - 1) % shareSlots);
+	token->seq = share->header->slot[token->slot].seq.load(std::memory_order_acquire);
+	return slotPixels(share, token->slot);
+}
+
+bool frameShareEnd(const FrameShare* share, const ShareToken* token) {
+	// reads of the pixels must finish before seq is checked again
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint32_t seq = share->header->slot[token->slot].seq.load(std::memory_order_relaxed);
+	return (token->seq & 1) == 0 && seq == token->seq;
+}
+
+bool frameShareRead(const FrameShare* share, unsigned char* frame, uint64_t* number, int64_t* time) {
+	int i;
+	ShareToken token;
+
+	for (i = 0; i < shareReadTries; i++) {
+		const unsigned char* pixels = frameShareBegin(share, &token);
+		if (pixels == nullptr) {
+			return false;
+		}
+		memcpy(frame, pixels, SW * SH);
+		uint64_t slotFrame = share->header->slot[token.slot].frame;
+		int64_t slotTime = share->header->slot[token.slot].time;
+		if (frameShareEnd(share, &token)) {
+			*number = slotFrame;
+			*time = slotTime;
+			return true;
+		}
+	}
+	return false;
+}
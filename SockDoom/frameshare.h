@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// defines for shared frame export settings
+#define shareMagic         0x53464453u             // "SDFS" at the start of the shared memory
+#define shareVersion       1                       // bumped when the layout changes
+#define shareSlots         4                       // newest frames kept in the ring
+
+// other processes map the shared memory read only and find the newest frame through the header,
+// with no copies or system calls per frame. each slot is a seqlock: its seq is odd while the
+// writer fills it, so a reader that sees the same even seq before and after reading has a whole frame
+
+// one frame of the ring
+struct ShareSlot {
+	std::atomic<uint32_t> seq;
+	uint32_t unused;
+	// frame number, counting from 1
+	uint64_t frame;
+	// steady clock nanoseconds when it was published, CLOCK_MONOTONIC on linux
+	int64_t time;
+};
+
+// start of the shared memory, the pixels of slot i follow at frameOffset + i * width * height
+struct ShareHeader {
+	uint32_t magic;
+	uint32_t version;
+	// frame size in pixels, one palette color per byte with row 0 the bottom of the screen
+	uint32_t width, height;
+	uint32_t slots;
+	uint32_t frameOffset;
+	// newest whole frame number, 0 before the first; it is in slot (latest - 1) % slots
+	std::atomic<uint64_t> latest;
+	// rgb of every palette color
+	unsigned char palette[256][3];
+	ShareSlot slot[shareSlots];
+};
+
+// one side of a shared frame ring, the game writes and any number of other processes read
+struct FrameShare {
+	ShareHeader* header;
+	// bytes mapped
+	size_t size;
+	// frames published so far by the writer
+	uint64_t published;
+	// true for the writer, which removes the name on close
+	bool owner;
+	char name[64];
+};
+
+// where the newest frame was when a reader started on it
+struct ShareToken {
+	int slot;
+	uint32_t seq;
+};
+
+// create the shared memory under name, replacing any left behind, and start writing frames into it
+bool frameShareCreate(FrameShare* share, const char* name);
+// open the shared memory another process created under name, read only
+bool frameShareOpen(FrameShare* share, const char* name);
+// unmap the shared memory, the writer also removes its name; readers keep their mapping until they close
+void frameShareClose(FrameShare* share);
+// copy a SW * SH palette frame into the next slot and make it the newest
+void frameSharePublish(FrameShare* share, const unsigned char* frame);
+// newest frame read in place, nullptr before the first; it is whole only if frameShareEnd() is true afterwards
+const unsigned char* frameShareBegin(const FrameShare* share, ShareToken* token);
+// true if the writer did not touch the slot since frameShareBegin()
+bool frameShareEnd(const FrameShare* share, const ShareToken* token);
+// copy the newest whole frame into frame, with its number and time; false before the first frame
+// or if the writer kept overwriting it
+bool frameShareRead(const FrameShare* share, unsigned char* frame, uint64_t* number, int64_t* time);
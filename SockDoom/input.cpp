@@ -0,0 +1,128 @@
+#include "input.h"
+
+#include "profiler.h"
+
+// field of keys an input key changes
+static int* keyField(Keys* keys, int key) {
+	switch (key) {
+		case INPUT_W:
+			return &keys->w;
+		case INPUT_A:
+			return &keys->a;
+		case INPUT_S:
+			return &keys->s;
+		case INPUT_D:
+			return &keys->d;
+		case INPUT_STRAFE_L:
+			return &keys->strafeL;
+		case INPUT_STRAFE_R:
+			return &keys->strafeR;
+		case INPUT_MLOOK:
+			return &keys->mlook;
+		case INPUT_JUMP:
+			return &keys->jump;
+		case INPUT_FLY:
+			return &keys->fly;
+	}
+	return nullptr;
+}
+
+void inputClear(InputQueue* queue) {
+	queue->head.store(0);
+	queue->tail.store(0);
+	queue->dropped = 0;
+}
+
+bool inputPush(InputQueue* queue, int key, int pressed) {
+	unsigned int tail = queue->tail.load(std::memory_order_relaxed);
+
+	if (tail - queue->head.load(std::memory_order_acquire) >= inputQueueSize) {
+		queue->dropped++;
+		return false;
+	}
+	InputEvent* event = &queue->events[tail % inputQueueSize];
+	event->key = key;
+	event->pressed = pressed;
+	event->time = profileNow();
+	// publish the event only once it is written
+	queue->tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+bool inputPop(InputQueue* queue, InputEvent* event) {
+	unsigned int head = queue->head.load(std::memory_order_relaxed);
+
+	if (head == queue->tail.load(std::memory_order_acquire)) {
+		return false;
+	}
+	*event = queue->events[head % inputQueueSize];
+	// hand the slot back to the producer only once it is read
+	queue->head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+void inputTick(InputQueue* queue, Keys* held, Keys* tick, int64_t* firstTime) {
+	InputEvent event;
+	int k;
+
+	// presses during the tick are collected in tick, then the keys still held are added
+	*tick = Keys();
+	*firstTime = 0;
+	while (inputPop(queue, &event)) {
+		int* heldKey = keyField(held, event.key);
+		int* tickKey = keyField(tick, event.key);
+		if (heldKey == nullptr) {
+			continue;
+		}
+		if (*firstTime == 0) {
+			*firstTime = event.time;
+		}
+
+		if (event.key == INPUT_FLY) {
+			if (event.pressed) {
+				*heldKey = !*heldKey;
+			}
+		}
+		else {
+			*heldKey = event.pressed;
+			if (event.pressed) {
+				*tickKey = 1;
+			}
+		}
+	}
+	for (k = 0; k < INPUT_COUNT; k++) {
+		if (k == INPUT_FLY) {
+			*keyField(tick, k) = *keyField(held, k);
+		}
+		else {
+			*keyField(tick, k) |= *keyField(held, k);
+		}
+	}
+}
+
+void latencyRecord(InputLatency* latency, int64_t nanoseconds) {
+	latency->samples[latency->count % latencySamples] = nanoseconds;
+	latency->count++;
+	if (nanoseconds > latency->worst) {
+		latency->worst = nanoseconds;
+	}
+}
+
+int64_t latencyAverage(const InputLatency* latency) {
+	int64_t total = 0;
+	int i;
+
+	int kept = (latency->count < latencySamples) ? static_cast<int>(latency->count) : latencySamples;
+	if (kept == 0) {
+		return 0;
+	}
+	for (i = 0; i < kept; i++) {
+		total += latency->samples[i];
+	}
+	return total / kept;
+}
+
+void latencyReset(InputLatency* latency) {
+	latency->count = 0;
+	latency->worst = 0;
+}
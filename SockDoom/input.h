@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "engine.h"
+
+// defines for input settings
+#define inputQueueSize     256                     // events waiting for the simulation, a power of two
+#define latencySamples     64                      // presented frames kept for the latency average
+
+// game keys an event can change, each matches a field of Keys
+enum InputKey {
+	INPUT_W,
+	INPUT_A,
+	INPUT_S,
+	INPUT_D,
+	INPUT_STRAFE_L,
+	INPUT_STRAFE_R,
+	INPUT_MLOOK,
+	INPUT_JUMP,
+	// flips Keys::fly when pressed, releases are ignored
+	INPUT_FLY,
+	INPUT_COUNT
+};
+
+struct InputEvent {
+	// which key, an InputKey
+	int key;
+	// 1 for a press, 0 for a release
+	int pressed;
+	// profileNow() when the event happened
+	int64_t time;
+};
+
+// single producer single consumer ring: the window thread pushes, the simulation pops
+struct InputQueue {
+	InputEvent events[inputQueueSize];
+	// total events popped and pushed, the ring holds events[head % size] to events[(tail - 1) % size]
+	std::atomic<unsigned int> head, tail;
+	// events thrown away because the ring was full, only touched by the producer
+	int dropped;
+};
+
+// time from an input event to the first presented frame that includes it
+struct InputLatency {
+	// the last latencySamples measurements in nanoseconds, newest at (count - 1) % latencySamples
+	int64_t samples[latencySamples];
+	int64_t count;
+	// worst measurement since the last reset
+	int64_t worst;
+};
+
+// empty the queue, only while neither side is using it
+void inputClear(InputQueue* queue);
+// add an event stamped with the current time, false if the queue is full
+bool inputPush(InputQueue* queue, int key, int pressed);
+// take the oldest event, false if there is none
+bool inputPop(InputQueue* queue, InputEvent* event);
+
+// apply every queued event to held, the keys that stay down between ticks, and return the keys for
+// this tick in tick: the keys held now plus any pressed since the last tick, so a key pressed and
+// released between two ticks still counts for one tick.
+// sets firstTime to the time of the oldest event applied, 0 if there was none
+void inputTick(InputQueue* queue, Keys* held, Keys* tick, int64_t* firstTime);
+
+// add a latency measurement in nanoseconds
+void latencyRecord(InputLatency* latency, int64_t nanoseconds);
+// average of the kept measurements in nanoseconds, 0 if there are none
+int64_t latencyAverage(const InputLatency* latency);
+void latencyReset(InputLatency* latency);
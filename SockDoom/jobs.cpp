@@ -0,0 +1,264 @@
+#include "jobs.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+#include "profiler.h"
+
+struct JobTask {
+	JobRange fn;
+	void* data;
+	int begin, end;
+	// tasks of the parallelFor that are not finished yet
+	std::atomic<int>* pending;
+};
+
+// tasks of one thread: the owner pushes and pops at the tail, other threads steal from the head
+struct JobQueue {
+	std::mutex lock;
+	JobTask tasks[maxQueuedJobs];
+	// tasks are tasks[head % maxQueuedJobs] to tasks[(tail - 1) % maxQueuedJobs]
+	int head, tail;
+};
+
+static JobQueue queues[maxJobThreads];
+// queues of the threads that are not workers, such as the main thread and the pipeline stages
+static JobQueue submitQueues[maxSubmitThreads];
+static std::atomic<bool> submitClaimed[maxSubmitThreads];
+// submit queues handed out so far, workers steal from these too
+static std::atomic<int> numSubmit(0);
+static std::mutex claimLock;
+static std::thread workers[maxJobThreads];
+static int numThreads = 1;
+
+// idle workers sleep until tasks are queued or they are told to quit
+static std::mutex sleepLock;
+static std::condition_variable wake;
+static std::atomic<int> queuedTasks(0);
+static bool quit = false;
+
+static thread_local int threadIndex = 0;
+
+// gives a submit queue back when its thread exits, its parallelFor calls have all returned by then
+struct SubmitSlot {
+	int index = -1;
+	~SubmitSlot() {
+		if (index >= 0) {
+			submitClaimed[index].store(false, std::memory_order_release);
+		}
+	}
+};
+static thread_local SubmitSlot submitSlot;
+
+// queue the current thread pushes to and pops from, nullptr for a thread without one
+static JobQueue* ownQueue() {
+	if (threadIndex != 0) {
+		return &queues[threadIndex];
+	}
+	if (submitSlot.index >= 0) {
+		return &submitQueues[submitSlot.index];
+	}
+	return nullptr;
+}
+
+// ownQueue(), claiming a submit queue the first time a thread that is not a worker asks
+static JobQueue* claimQueue() {
+	int i;
+
+	if (threadIndex != 0 || submitSlot.index >= 0) {
+		return ownQueue();
+	}
+	std::lock_guard<std::mutex> guard(claimLock);
+	for (i = 0; i < maxSubmitThreads; i++) {
+		bool expected = false;
+		if (submitClaimed[i].compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+			submitSlot.index = i;
+			if (i >= numSubmit.load()) {
+				numSubmit.store(i + 1);
+			}
+			return &submitQueues[i];
+		}
+	}
+	return nullptr;
+}
+
+// add a task to the tail of a queue, false if it is full
+static bool pushTask(JobQueue* queue, const JobTask* task) {
+	std::lock_guard<std::mutex> guard(queue->lock);
+
+	if (queue->tail - queue->head >= maxQueuedJobs) {
+		return false;
+	}
+	queue->tasks[queue->tail++ % maxQueuedJobs] = *task;
+	queuedTasks++;
+	return true;
+}
+
+// take the newest task of a thread's own queue, or the oldest of another thread's queue
+static bool takeTask(JobQueue* queue, bool own, JobTask* task) {
+	std::lock_guard<std::mutex> guard(queue->lock);
+
+	if (queue->head == queue->tail) {
+		return false;
+	}
+	if (own) {
+		*task = queue->tasks[--queue->tail % maxQueuedJobs];
+	}
+	else {
+		*task = queue->tasks[queue->head++ % maxQueuedJobs];
+	}
+	queuedTasks--;
+	return true;
+}
+
+// run one task from this thread's queue or stolen from a worker's, false if there was none;
+// workers also steal from the submit queues, other threads leave each other's queues alone
+static bool runTask() {
+	JobTask task;
+	JobQueue* own = ownQueue();
+	int i;
+
+	bool found = own != nullptr && takeTask(own, true, &task);
+	for (i = 1; i < numThreads && !found; i++) {
+		int thread = (threadIndex + i) % numThreads;
+		found = thread != 0 && takeTask(&queues[thread], false, &task);
+	}
+	if (threadIndex != 0) {
+		int submitted = numSubmit.load();
+		for (i = 0; i < submitted && !found; i++) {
+			found = takeTask(&submitQueues[i], false, &task);
+		}
+	}
+	if (!found) {
+		return false;
+	}
+
+	task.fn(task.begin, task.end, task.data);
+	task.pending->fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+static void workerLoop(int index) {
+	threadIndex = index;
+	profileSetThread(jobProfileThread + index - 1);
+
+	for (;;) {
+		if (runTask()) {
+			continue;
+		}
+		std::unique_lock<std::mutex> guard(sleepLock);
+		wake.wait(guard, [] { return quit || queuedTasks.load() > 0; });
+		if (quit) {
+			return;
+		}
+	}
+}
+
+void jobsInit(int threads) {
+	static bool registered = false;
+	int i;
+
+	jobsShutdown();
+	// workers must be joined before the thread objects are destroyed at exit
+	if (!registered) {
+		std::atexit(jobsShutdown);
+		registered = true;
+	}
+	if (threads <= 0) {
+		threads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	if (threads < 1) {
+		threads = 1;
+	}
+	if (threads > maxJobThreads) {
+		threads = maxJobThreads;
+	}
+
+	quit = false;
+	for (i = 0; i < threads; i++) {
+		queues[i].head = 0;
+		queues[i].tail = 0;
+	}
+	for (i = 0; i < maxSubmitThreads; i++) {
+		submitQueues[i].head = 0;
+		submitQueues[i].tail = 0;
+	}
+	numThreads = threads;
+	threadIndex = 0;
+	for (i = 1; i < threads; i++) {
+		workers[i] = std::thread(workerLoop, i);
+	}
+}
+
+void jobsShutdown() {
+	int i;
+
+	{
+		std::lock_guard<std::mutex> guard(sleepLock);
+		quit = true;
+	}
+	wake.notify_all();
+	for (i = 1; i < numThreads; i++) {
+		workers[i].join();
+	}
+	numThreads = 1;
+}
+
+int jobThreads() {
+	return numThreads;
+}
+
+int jobThread() {
+	return threadIndex;
+}
+
+void parallelFor(int count, int grain, JobRange fn, void* data) {
+	if (grain < 1) {
+		grain = 1;
+	}
+	JobQueue* queue = (numThreads == 1 || count <= grain) ? nullptr : claimQueue();
+	if (queue == nullptr) {
+		if (count > 0) {
+			fn(0, count, data);
+		}
+		return;
+	}
+
+	std::atomic<int> pending((count + grain - 1) / grain);
+	JobTask task;
+	task.fn = fn;
+	task.data = data;
+	task.pending = &pending;
+
+	// queue ranges back to front so this thread pops the first range first
+	int queued = 0;
+	int begin;
+	for (begin = ((count - 1) / grain) * grain; begin >= 0; begin -= grain) {
+		task.begin = begin;
+		task.end = (begin + grain < count) ? begin + grain : count;
+		if (pushTask(queue, &task)) {
+			queued++;
+		}
+		else {
+			fn(task.begin, task.end, data);
+			pending.fetch_sub(1, std::memory_order_release);
+		}
+	}
+	if (queued > 1) {
+		// taking the lock orders this with a worker that is about to sleep
+		{
+			std::lock_guard<std::mutex> guard(sleepLock);
+		}
+		wake.notify_all();
+	}
+
+	// help with any task until this parallelFor is done
+	while (pending.load(std::memory_order_acquire) > 0) {
+		if (!runTask()) {
+			std::this_thread::yield();
+		}
+	}
+}
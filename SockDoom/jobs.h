@@ -0,0 +1,28 @@
+#pragma once
+
+// defines for job system settings
+#define maxJobThreads      64                      // most threads, counting the calling thread
+#define maxQueuedJobs      1024                    // most tasks waiting in one thread's queue
+#define maxSubmitThreads   64                      // most threads other than workers in parallelFor at once
+#define jobProfileThread   16                      // profileSetThread() number of worker 1, the others follow
+
+// work on items begin to end - 1 of a parallel for
+typedef void (*JobRange)(int begin, int end, void* data);
+
+// start threads - 1 persistent workers, the calling thread is the last one; 0 uses every core.
+// calling it again restarts the workers with the new count
+void jobsInit(int threads);
+// stop and join the workers, parallelFor runs inline afterwards; also called at exit
+void jobsShutdown();
+// number of threads that run jobs, 1 when no workers are running
+int jobThreads();
+// index of the current thread, 1 up for workers and 0 for every other thread
+int jobThread();
+
+// call fn over 0 to count - 1 in ranges of at least grain items spread over every thread,
+// returning when all of them are done. ranges split the same way for any thread count, so
+// work that only writes its own items gives the same results on any number of threads.
+// the calling thread works too, and parallelFor can be called from inside a job.
+// a thread that is not a worker gets a queue of its own the first time it calls parallelFor and keeps
+// it until it exits; only workers steal from it, and past maxSubmitThreads such threads run inline
+void parallelFor(int count, int grain, JobRange fn, void* data);
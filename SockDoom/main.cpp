@@ -1,450 +1,80 @@
-#include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
-
-// defines for window settings
-#define res                1                       // window resolution: 1=200x150 2=400x300 4=800x600
-#define SW                 200*res                 // screen width
-#define SH                 150*res                 // screen height
-#define SW2                (SW/2)                  // half of screen width
-#define SH2                (SH/2)                  // half of screen height
-#define pixelScale         4/res                   // OpenGL pixel scale
-#define GLSW               (SW*pixelScale)         // OpenGL window width
-#define GLSH               (SH*pixelScale)         // OpenGL window height
-
-// defines for math constants
-#define PI                 (3.1415926535897932f)   // pi constant
-
-// defines for game variables
-#define numSect            4                       // number of sectors
-#define numWall            16                      // number of walls
-
-struct Time {
-	int frame1, frame2;
-};
-
-struct Keys {
-	// move up, down, left, right
-	int w, a, s, d;
-	// strafe left, right
-	int strafeL, strafeR;
-	// move up, down, look up, down
-	int mlook;
-};
-
-struct Rotation {
-	// save sin and cos as values 0-360 degrees
-	float cos[360];
-	float sin[360];
-};
-
-struct Player {
-	// player position
-	int x, y, z;
-	// player angle of rotation
-	int angle;
-	// variable to look up and down
-	int look;
-};
-
-struct Wall {
-	// bottom line point 1
-	int x1, y1;
-	// bottom line point 2
-	int x2, y2;
-	// wall color
-	int color;
-};
-
-struct Sector {
-	// wall number start and end
-	int wallStart, wallEnd;
-	// height of bottom and top
-	int z1, z2;
-	// center position of sector
-	int x, y;
-	// add y distances to sort drawing order
-	int dist;
-	// bottom and top colors
-	int colorBot, colorTop;
-	// array to hold points for surface
-	int surfaces[SW];
-	// variable to determine which surface to draw (top, bottom, none)
-	int surface;
-};
-
-Time frameTime;
-Keys keys;
-Rotation rot;
-Player player;
-Wall walls[30];
-Sector sectors[30];
-
-// draw a pixel at x/y with rgb
-void pixel(int x, int y, int color) {
-	int rgb[3];
-	switch (color) {
-		case 0:  // yellow
-			rgb[0] = 255;
-			rgb[1] = 255;
-			rgb[2] = 0;
-			break;
-		case 1:  // dark yellow
-			rgb[0] = 160;
-			rgb[1] = 160;
-			rgb[2] = 0;
-			break;
-		case 2:  // green
-			rgb[0] = 0;
-			rgb[1] = 255;
-			rgb[2] = 0;
-			break;
-		case 3:  // dark green
-			rgb[0] = 0;
-			rgb[1] = 160;
-			rgb[2] = 0;
-			break;
-		case 4:  // cyan
-			rgb[0] = 0;
-			rgb[1] = 255;
-			rgb[2] = 255;
-			break;
-		case 5:  // dark cyan
-			rgb[0] = 0;
-			rgb[1] = 160;
-			rgb[2] = 160;
-			break;
-		case 6:  // brown
-			rgb[0] = 160;
-			rgb[1] = 100;
-			rgb[2] = 0;
-			break;
-		case 7:  // dark brown
-			rgb[0] = 110;
-			rgb[1] = 50;
-			rgb[2] = 0;
-			break;
-		case 8:  // background
-			rgb[0] = 0;
-			rgb[1] = 60;
-			rgb[2] = 130;
-			break;
-	}
-	glad_glColor3ub(rgb[0], rgb[1], rgb[2]);
-	glad_glBegin(GL_POINTS);
-	glad_glVertex2i(x * pixelScale + 2, y * pixelScale + 2);
-	glad_glEnd();
-}
-
-void movePlayer() {
-	// move up, down, left, right
-	if (keys.a == 1 && keys.mlook == 0) {
-		player.angle -= 4;
-
-		if (player.angle < 0) {
-			player.angle += 360;
-		}
-	}
-	if (keys.d == 1 && keys.mlook == 0) {
-		player.angle += 4;
-
-		if (player.angle > 359) {
-			player.angle -= 360;
-		}
-	}
-
-	int deltaX = rot.sin[player.angle] * 10.0;
-	int deltaY = rot.cos[player.angle] * 10.0;
-
-	if (keys.w == 1 && keys.mlook == 0) {
-		player.x += deltaX;
-		player.y += deltaY;
-	}
-	if (keys.s == 1 && keys.mlook == 0) {
-		player.x -= deltaX;
-		player.y -= deltaY;
-	}
-
-	// strafe left, right
-	if (keys.strafeL == 1) {
-		player.x -= deltaY;
-		player.y += deltaX;
-	}
-	if (keys.strafeR == 1) {
-		player.x += deltaY;
-		player.y -= deltaX;
-	}
-
-	// move up, down, look up, look down
-	if (keys.a == 1 && keys.mlook == 1) {
-		player.look -= 1;
-	}
-	if (keys.d == 1 && keys.mlook == 1) {
-		player.look += 1;
-	}
-	if (keys.w == 1 && keys.mlook == 1) {
-		player.z -= 4;
-	}
-	if (keys.s == 1 && keys.mlook == 1) {
-		player.z += 4;
-	}
-}
-
-void clearBackground() {
-	int x, y;
-
-	for (y = 0; y < SH; y++) {
-		// clear background color
-		for (x = 0; x < SW; x++) { 
-			pixel(x, y, 8);
-		}
-	}
-}
-
-void cullBehindPlayer(int* x1, int* y1, int* z1, int x2, int y2, int z2) {
-	// distance plane to point a (first point)
-	float distA = *y1;
-	// distance plane to point b (second point)
-	float distB = y2;
-
-	float dist = distA - distB;
-	if (dist == 0) {
-		dist = 1;
-	}
-
-	// intersection factor (normalize between 0 and 1)
-	float norm = distA / (distA - distB);
-
-	*x1 = *x1 + norm * (x2 - (*x1));
-	*y1 = *y1 + norm * (y2 - (*y1));
-	// prevent divide by 0
-	if (*y1 == 0) {
-		*y1 = 1;
-	}
-	*z1 = *z1 + norm * (z2 - (*z1));
-}
-
-void drawWall(int x1, int x2, int b1, int b2, int t1, int t2, int color, int surfaceNum) {
-	int x, y;
-
-	// hold the difference in distnce between the bottom two points (b1 and b2)
-	// y distance of the bottom line
-	int distYBottom = b2 - b1;
-	// y distance of top line
-	int distYTop = t2 - t1;
-	// x distance
-	int distX = x2 - x1;
-
-	// hold initial value of x1 starting position
-	int xStart = x1;
-
-	// cull x
-	if (x1 < 1) {
-		x1 = 1;  // cull left
-	}
-	if (x2 < 1) {
-		x2 = 1;  // cull left
-	}
-	if (x1 > SW - 1) {
-		x1 = SW - 1;  // cull right
-	}
-	if (x2 > SW - 1) {
-		x2 = SW - 1;  // cull right
-	}
-
-	// draw vertical lines between x1 and x2
-	for (x = x1; x < x2; x++) {
-		// find y start and end point
-		// y bottom point
-		int y1 = distYBottom * (x - xStart + 0.5) / distX + b1;
-		int y2 = distYTop * (x - xStart + 0.5) / distX + t1;
-
-		// cull y
-		if (y1 < 1) {
-			y1 = 1;
-		}
-		if (y2 < 1) {
-			y2 = 1;
-		}
-		if (y1 > SH - 1) {
-			y1 = SH - 1;
-		}
-		if (y2 > SH - 1) {
-			y2 = SH - 1;
-		}
-
-		// draw surface
-		if (sectors[surfaceNum].surface == 1) {
-			// save bottom points
-			sectors[surfaceNum].surfaces[x] = y1;
-			continue;
-		}
-		if (sectors[surfaceNum].surface == 2) {
-			// save top points
-			sectors[surfaceNum].surfaces[x] = y2;
-			continue;
-		}
-		if (sectors[surfaceNum].surface == -1) {
-			// bottom
-			for (y = sectors[surfaceNum].surfaces[x]; y < y1; y++) {
-				pixel(x, y, sectors[surfaceNum].colorBot);
-			}
-		}
-		if (sectors[surfaceNum].surface == -2) {
-			// top
-			for (y = y1; y < sectors[surfaceNum].surfaces[x]; y++) {
-				pixel(x, y, sectors[surfaceNum].colorTop);
-			}
-		}
-
-		// draw wall points
-		for (y = y1; y < y2; y++) {
-			pixel(x, y, color);
-		}
-	}
-}
-
-int distance(int x1, int y1, int x2, int y2) {
-	int distance = sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
-	return distance;
-}
-
-void draw3D() {
-	int s, w, i;
-	int wallX[4], wallY[4], wallZ[4];
-	float wallCos = rot.cos[player.angle];
-	float wallSin = rot.sin[player.angle];
-
-	// order sectors by distance using bubble sort
-	for (s = 0; s < numSect - 1; s++) {
-		for (w = 0; w < numSect - s - 1; w++) {
-			if (sectors[w].dist < sectors[w + 1].dist) {
-				Sector temp = sectors[w];
-				sectors[w] = sectors[w + 1];
-				sectors[w + 1] = temp;
-			}
-		}
-	}
-
-	// draw sectors
-	for (s = 0; s < numSect; s++) {
-		//clear distance
-		sectors[s].dist = 0;
-
-		// bottom surface
-		if (player.z < sectors[s].z1) {
-			sectors[s].surface = 1;
-		}
-		// top surface
-		else if (player.z > sectors[s].z2) {
-			sectors[s].surface = 2;
-		}
-		// no surface
-		else {
-			sectors[s].surface = 0;
-		}
-
-		// loop to draw back faces of walls
-		for (i = 0; i < 2; i++) {
-			for (w = sectors[s].wallStart; w < sectors[s].wallEnd; w++) {
-				// offset the bottom 2 points by player position
-				int x1 = walls[w].x1 - player.x;
-				int y1 = walls[w].y1 - player.y;
-				int x2 = walls[w].x2 - player.x;
-				int y2 = walls[w].y2 - player.y;
-
-				// swap for surface
-				if (i == 0) {
-					int swap = x1;
-					x1 = x2;
-					x2 = swap;
-					swap = y1;
-					y1 = y2;
-					y2 = swap;
-				}
-
-				// rotate points around player for wall x position
-				wallX[0] = x1 * wallCos - y1 * wallSin;
-				wallX[1] = x2 * wallCos - y2 * wallSin;
-				// top line has same x
-				wallX[2] = wallX[0];
-				wallX[3] = wallX[1];
-
-				// rotate points around player for wall y position
-				wallY[0] = y1 * wallCos + x1 * wallSin;
-				wallY[1] = y2 * wallCos + x2 * wallSin;
-				// top line has same y
-				wallY[2] = wallY[0];
-				wallY[3] = wallY[1];
-
-				// store this wall's distance
-				sectors[s].dist += distance(0, 0, (wallX[0] + wallX[1]) / 2, (wallY[0] + wallY[1]) / 2);
-
-				// rotate points around player for wall z position
-				wallZ[0] = sectors[s].z1 - player.z + ((player.look * wallY[0]) / 32.0);
-				wallZ[1] = sectors[s].z1 - player.z + ((player.look * wallY[1]) / 32.0);
-				// top line has higher z
-				wallZ[2] = wallZ[0] + sectors[s].z2;
-				wallZ[3] = wallZ[1] + sectors[s].z2;
-
-				// dont draw if behind player
-				if (wallY[0] < 1 && wallY[1] < 1) {
-					continue;
-				}
-				// cull if one side is behind player
-				if (wallY[0] < 1) {
-					// bottom line
-					cullBehindPlayer(&wallX[0], &wallY[0], &wallZ[0], wallX[1], wallY[1], wallZ[1]);
-					// top line
-					cullBehindPlayer(&wallX[2], &wallY[2], &wallZ[2], wallX[3], wallY[3], wallZ[3]);
-				}
-				// cull if other side is behing player
-				if (wallY[1] < 1) {
-					// bottom line
-					cullBehindPlayer(&wallX[1], &wallY[1], &wallZ[1], wallX[0], wallY[0], wallZ[0]);
-					// top line
-					cullBehindPlayer(&wallX[3], &wallY[3], &wallZ[3], wallX[2], wallY[2], wallZ[2]);
-				}
-
-				// convert wall world position into screen position
-				wallX[0] = wallX[0] * 200 / wallY[0] + SW2;
-				wallY[0] = wallZ[0] * 200 / wallY[0] + SH2;
-				wallX[1] = wallX[1] * 200 / wallY[1] + SW2;
-				wallY[1] = wallZ[1] * 200 / wallY[1] + SH2;
-				wallX[2] = wallX[2] * 200 / wallY[2] + SW2;
-				wallY[2] = wallZ[2] * 200 / wallY[2] + SH2;
-				wallX[3] = wallX[3] * 200 / wallY[3] + SW2;
-				wallY[3] = wallZ[3] * 200 / wallY[3] + SH2;
-
-				// draw points
-				drawWall(wallX[0], wallX[1], wallY[0], wallY[1], wallY[2], wallY[3], walls[w].color, s);
-			}
-
-			// find average sector distance
-			sectors[s].dist /= (sectors[s].wallEnd - sectors[s].wallStart);
-			// flip surface number to negative to draw surface
-			sectors[s].surface *= -1;
-		}
-	}
-}
+#include "actor.h"
+#include "capture.h"
+#include "demo.h"
+#include "detail.h"
+#include "engine.h"
+#include "frameshare.h"
+#include "input.h"
+#include "jobs.h"
+#include "overlay.h"
+#include "pipeline.h"
+#include "present.h"
+#include "profiler.h"
+#include "render.h"
+#include "stream.h"
+#include "upscale.h"
+
+// defines for debug output
+#define traceFile          "sockdoom_trace.json"   // chrome trace written by the T key
+#define checkSkipped       77                      // exit code of --check-present without a GL 3.3 display
+
+// the game in the window
+Engine* engine;
+// simulates and renders the game on threads of its own, and queues the window's key events
+Pipeline pipeline;
+// time from a key event to the swap of the first frame showing it, measured by the present thread
+InputLatency inputLatency;
+// toggled by the P key
+int showOverlay;
+// render mode of the window, toggled by the H key
+int viewMode;
+// column mode of the window, cycled by the L key or picked by detail when --detail-budget is given
+int columnMode;
+DetailControl detail;
+bool autoDetail;
+// demo being recorded or played
+Demo demo;
+// shared memory other processes read the frames from, if --share is given
+FrameShare share;
+// stream of the presented frames, if --capture or --capture-rgb is given
+Capture capture;
+// viewers of the presented frames, if --serve is given
+StreamServer server;
+// frames on their way to the present thread, which owns the GL context
+TripleBuffer presentFrames;
+// scales the headless frame up, if --scale is given
+Upscaler upscaler;
 
 void display(GLFWwindow* window) {
-	int x, y;
-
 	// only draw 20 frames/second
-	if (frameTime.frame1 - frameTime.frame2 >= 50) {
-		clearBackground();
-		movePlayer();
-		draw3D();
-
-		frameTime.frame2 = frameTime.frame1;
-		// swap buffers
-		glfwSwapBuffers(window);
+	if (engine->frameTime.frame1 - engine->frameTime.frame2 >= 50) {
+		// the last tick and the last frame are done, the profiler frame spans both
+		pipelineWait(&pipeline);
+		if (pipelineDemoDone(&pipeline)) {
+			glfwSetWindowShouldClose(window, true);
+		}
+		profilerEndFrame();
+		profilerBeginFrame();
+		if (autoDetail) {
+			columnMode = detailUpdate(&detail, pipelineRenderTime(&pipeline));
+		}
+		pipelineKick(&pipeline, showOverlay, viewMode, columnMode);
+
+		engine->frameTime.frame2 = engine->frameTime.frame1;
+		// the render thread already handed the finished frame to the present thread, the others
+		// get it while the next one is rendered and simulated
+		frameSharePublish(&share, pipelineFrame(&pipeline));
+		captureFrame(&capture, pipelineFrame(&pipeline));
+		streamPublish(&server, pipelineFrame(&pipeline));
 	}
 
 	// 1000 Milliseconds per second
-	frameTime.frame1 = static_cast<int>(glfwGetTime() * 1000);
+	engine->frameTime.frame1 = static_cast<int>(glfwGetTime() * 1000);
 }
 
 void processInput(GLFWwindow* window, int keyPressed, int scancode, int action, int mods) {
@@ -453,127 +83,260 @@ void processInput(GLFWwindow* window, int keyPressed, int scancode, int action,
 
 		switch (keyPressed) {
 			case GLFW_KEY_W:
-				keys.w = state;
+				inputPush(&pipeline.input, INPUT_W, state);
 				break;
 			case GLFW_KEY_S:
-				keys.s = state;
+				inputPush(&pipeline.input, INPUT_S, state);
 				break;
 			case GLFW_KEY_A:
-				keys.a = state;
+				inputPush(&pipeline.input, INPUT_A, state);
 				break;
 			case GLFW_KEY_D:
-				keys.d = state;
+				inputPush(&pipeline.input, INPUT_D, state);
 				break;
 			case GLFW_KEY_M:
-				keys.mlook = state;
+				inputPush(&pipeline.input, INPUT_MLOOK, state);
 				break;
 			case GLFW_KEY_E:
-				keys.strafeR = state;
+				inputPush(&pipeline.input, INPUT_STRAFE_R, state);
 				break;
 			case GLFW_KEY_Q:
-				keys.strafeL = state;
+				inputPush(&pipeline.input, INPUT_STRAFE_L, state);
+				break;
+			case GLFW_KEY_SPACE:
+				inputPush(&pipeline.input, INPUT_JUMP, state);
+				break;
+			case GLFW_KEY_F:
+				// toggles flying on each press
+				inputPush(&pipeline.input, INPUT_FLY, state);
 				break;
 			case GLFW_KEY_ESCAPE:
 				glfwSetWindowShouldClose(window, true);
 				break;
 		}
 	}
+
+	if (action == GLFW_PRESS) {
+		switch (keyPressed) {
+			case GLFW_KEY_P:
+				// toggle profiler overlay
+				showOverlay = !showOverlay;
+				break;
+			case GLFW_KEY_H:
+				// toggle overdraw heatmap
+				viewMode = (viewMode == RENDER_OVERDRAW) ? RENDER_NORMAL : RENDER_OVERDRAW;
+				break;
+			case GLFW_KEY_L:
+				// cycle full, low detail and interlaced columns, taking over from the detail controller
+				columnMode = (columnMode + 1) % 3;
+				autoDetail = false;
+				break;
+			case GLFW_KEY_T:
+				// export the profiler ring buffer
+				if (profilerExportTrace(traceFile)) {
+					std::cout << "Wrote " << traceFile << std::endl;
+				}
+				else {
+					std::cout << "Failed to write " << traceFile << std::endl;
+				}
+				break;
+		}
+	}
 }
 
-int loadSectors[] = {
-	// wall start, wall end, z1 (bottom of wall) height, z2 (top of wall) height, bottom color, top color
-	 0,  4,  0, 40,  2,  3,  // sector 1
-	 4,  8,  0, 40,  4,  5,  // sector 2
-	 8, 12,  0, 40,  6,  7,  // sector 3
-    12, 16,  0, 40,  0,  1,  // sector 4
-};
+// show the frames of a remote game or timedemo until it stops or the window closes
+int runViewer(GLFWwindow* window, const char* host, int port) {
+	static StreamReader reader;
 
-int loadWalls[] = {
-	// x1, y1, x2, y2, color
-	 0,  0, 32,  0,  0,
-	32,  0, 32, 32,  1,
-	32, 32,  0, 32,  0,
-	 0, 32,  0,  0,  1,
+	if (!streamConnect(&reader, host, port)) {
+		return -1;
+	}
+	if (!presentStart(window, &presentFrames, &inputLatency)) {
+		streamDisconnect(&reader);
+		return -1;
+	}
+	while (!glfwWindowShouldClose(window) && streamReceive(&reader)) {
+		memcpy(tripleBack(&presentFrames), reader.frame, SW * SH);
+		triplePublish(&presentFrames, 0);
+		glfwPollEvents();
+	}
+	presentStop();
+	std::cout << "Received " << reader.number << " frames, " << reader.bytesReceived << " bytes" << std::endl;
+	streamDisconnect(&reader);
+	return 0;
+}
 
-	64,  0, 96,  0,  2,
-	96,  0, 96, 32,  3,
-	96, 32, 64, 32,  2,
-	64, 32, 64,  0,  3,
+// render one frame from the current player position without opening a window, scaled up by upscaler
+int renderHeadless(const char* path) {
+	int i;
 
-	64, 64, 96, 64,  4,
-	96, 64, 96, 96,  5,
-	96, 96, 64, 96,  4,
-	64, 96, 64, 64,  5,
+	renderStill(engine);
 
-	 0, 64, 32, 64,  6,
-	32, 64, 32, 96,  7,
-	32, 96,  0, 96,  6,
-	 0, 96,  0, 64,  7,
-};
+	if (engine->view.renderMode == RENDER_OVERDRAW) {
+		const unsigned short* overdraw = engine->view.overdraw;
+		int maxWrites = 0;
+		long long totalWrites = 0;
+		for (i = 0; i < SW * SH; i++) {
+			totalWrites += overdraw[i];
+			if (overdraw[i] > maxWrites) {
+				maxWrites = overdraw[i];
+			}
+		}
+		std::cout << "Overdraw: " << static_cast<double>(totalWrites) / (SW * SH) << " average, " << maxWrites << " max writes per pixel" << std::endl;
+		resolveOverdraw(&engine->view);
+	}
 
-void init() {
-	int x;
+	upscaleFrame(&upscaler, engine->view.frameBuffer);
+	if (!writePalettePPM(upscaler.out.data(), upscaler.width, upscaler.height, path)) {
+		std::cout << "Failed to write " << path << std::endl;
+		return -1;
+	}
+	std::cout << "Wrote " << path << std::endl;
+	return 0;
+}
 
-	// store sin/cos in degrees
-	for (x = 0; x < 360; x++) {
-		rot.cos[x] = cos(x / 180.0 * PI);
-		rot.sin[x] = sin(x / 180.0 * PI);
+int main(int argc, char** argv) {
+	const char* headlessPath = nullptr;
+	const char* mapPath = nullptr;
+	int pose[5];
+	int hasPose = 0;
+	int threads = 0;
+	const char* recordPath = nullptr;
+	const char* playPath = nullptr;
+	const char* shareName = nullptr;
+	const char* capturePath = nullptr;
+	int captureFormat = CAPTURE_Y4M;
+	int servePort = -1;
+	const char* connectHost = nullptr;
+	int connectPort = 0;
+	int overdrawMode = 0;
+	int checkPresent = 0;
+	int startColumns = COLUMNS_FULL;
+	int detailBudget = 0;
+	int scale = 1;
+	int scaleFilter = UPSCALE_NEAREST;
+	int i;
+
+	// --overdraw starts in heatmap mode, --headless <file.ppm> renders one frame without a window,
+	// --pose <x> <y> <z> <angle> <look> sets the starting camera, --map <file.map> replaces the built-in map,
+	// --threads <n> sets the job threads, all cores by default, --record <file.dem> records a demo
+	// and --playdemo <file.dem> plays one back, using its own map and start. --share <name> publishes
+	// every presented frame to shared memory for other processes, see frameshare.h. --capture <file.y4m>
+	// and --capture-rgb <file.rgb> write every presented frame as y4m or raw rgb24, "-" for stdout.
+	// --serve <port> streams every presented frame to viewers, and --connect <host> <port> is a viewer
+	// that shows another game's stream instead of playing. --check-present draws the first frame through
+	// the GL presentation path, compares it to the frame and exits. --scale <n> writes the headless frame
+	// n times the size, every pixel a square or with --scale2x smoothed by scale2x for n of 2, 4 or 8.
+	// --low-detail and --interlaced draw half the columns, see COLUMNS_LOW and COLUMNS_INTERLACED, and
+	// --detail-budget <ms> switches to low detail, or interlacing if given, whenever rendering runs over ms
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--overdraw") == 0) {
+			overdrawMode = 1;
+		}
+		else if (strcmp(argv[i], "--low-detail") == 0) {
+			startColumns = COLUMNS_LOW;
+		}
+		else if (strcmp(argv[i], "--interlaced") == 0) {
+			startColumns = COLUMNS_INTERLACED;
+		}
+		else if (strcmp(argv[i], "--detail-budget") == 0 && i + 1 < argc) {
+			detailBudget = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--check-present") == 0) {
+			checkPresent = 1;
+		}
+		else if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+			headlessPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--scale") == 0 && i + 1 < argc) {
+			scale = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--scale2x") == 0) {
+			scaleFilter = UPSCALE_SCALE2X;
+		}
+		else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+			mapPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--pose") == 0 && i + 5 < argc) {
+			for (int p = 0; p < 5; p++) {
+				pose[p] = atoi(argv[++i]);
+			}
+			hasPose = 1;
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			recordPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--playdemo") == 0 && i + 1 < argc) {
+			playPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--share") == 0 && i + 1 < argc) {
+			shareName = argv[++i];
+		}
+		else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+			servePort = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--connect") == 0 && i + 2 < argc) {
+			connectHost = argv[++i];
+			connectPort = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+			capturePath = argv[++i];
+			captureFormat = CAPTURE_Y4M;
+		}
+		else if (strcmp(argv[i], "--capture-rgb") == 0 && i + 1 < argc) {
+			capturePath = argv[++i];
+			captureFormat = CAPTURE_RGB;
+		}
+		else {
+			std::cout << "Unknown argument " << argv[i] << std::endl;
+			return -1;
+		}
 	}
 
-	// initialize player
-	player.x = 70;
-	player.y = -110;
-	player.z = 20;
-	player.angle = 0;
-	player.look = 0;
+	jobsInit(threads);
+	profilerInit();
+	engine = createEngine();
+	engine->view.renderMode = overdrawMode ? RENDER_OVERDRAW : RENDER_NORMAL;
+	engine->view.columnMode = startColumns;
 
-	// load sectors
-	int s, w;
-	int v1 = 0;
-	int v2 = 0;
-	for (s = 0; s < numSect; s++) {
-		// wall start number
-		sectors[s].wallStart = loadSectors[v1 + 0];
-		// wall end number
-		sectors[s].wallEnd = loadSectors[v1 + 1];
-		// sector bottom height
-		sectors[s].z1 = loadSectors[v1 + 2];
-		// sector top height
-		sectors[s].z2 = loadSectors[v1 + 3] - loadSectors[v1 + 2];
-		// sector bottom color
-		sectors[s].colorBot = loadSectors[v1 + 4];
-		// sector top color
-		sectors[s].colorTop = loadSectors[v1 + 5];
-		v1 += 6;
-		
-		// load walls
-		for (w = sectors[s].wallStart; w < sectors[s].wallEnd; w++) {
-			// bottom x1
-			walls[w].x1 = loadWalls[v2 + 0];
-			// bottom y1
-			walls[w].y1 = loadWalls[v2 + 1];
-			// top x2
-			walls[w].x2 = loadWalls[v2 + 2];
-			// top y2
-			walls[w].y2 = loadWalls[v2 + 3];
-			// wall color
-			walls[w].color = loadWalls[v2 + 4];
-			v2 += 5;
+	if (headlessPath != nullptr) {
+		if (mapPath != nullptr && !loadMap(engine, mapPath)) {
+			destroyEngine(engine);
+			return -1;
 		}
+		if (hasPose) {
+			setPose(engine, pose);
+		}
+		if (!upscaleInit(&upscaler, scale, scaleFilter)) {
+			destroyEngine(engine);
+			return -1;
+		}
+		int result = renderHeadless(headlessPath);
+		destroyEngine(engine);
+		return result;
 	}
-}
 
-int main() {
 	if (!glfwInit()) {
 		std::cout << "Failed to initialize GLFW" << std::endl;
-		return -1;
+		return checkPresent ? checkSkipped : -1;
 	}
 
+	// the present thread only needs a texture and a shader, so no compatibility profile
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GLFW_TRUE);
+	if (checkPresent) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
 	GLFWwindow* window = glfwCreateWindow(GLSW, GLSH, "Sock Doom", nullptr, nullptr);
 	if (window == NULL) {
 		std::cout << "Failed to open GLFW window" << std::endl;
 		glfwTerminate();
-		return -1;
+		return checkPresent ? checkSkipped : -1;
 	}
 
 	//prevent window scaling
@@ -583,24 +346,140 @@ int main() {
 
 	if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
 		std::cout << "Failed to initialize GLAD" << std::endl;
-		return -1;
+		glfwTerminate();
+		return checkPresent ? checkSkipped : -1;
 	}
 
-	glad_glPointSize(pixelScale);
-	// set origin to bottom left
-	glad_glOrtho(0, GLSW, 0, GLSH, -1, 1);
-
-	init();
+	if (connectHost != nullptr) {
+		int result = runViewer(window, connectHost, connectPort);
+		destroyEngine(engine);
+		glfwTerminate();
+		return result;
+	}
+	if (mapPath != nullptr && !loadMap(engine, mapPath)) {
+		glfwTerminate();
+		return -1;
+	}
+	if (hasPose) {
+		setPose(engine, pose);
+	}
+	if (checkPresent) {
+		renderStill(engine);
+		int mismatches = presentCheck(window, engine->view.frameBuffer);
+		if (mismatches >= 0) {
+			std::cout << "Present check: " << mismatches << " window pixels differ" << std::endl;
+		}
+		destroyEngine(engine);
+		glfwTerminate();
+		return (mismatches == 0) ? 0 : -1;
+	}
+	pipelineInit(&pipeline);
+	if (playPath != nullptr) {
+		if (!demoRead(&demo, playPath) || !demoStart(engine, &demo)) {
+			glfwTerminate();
+			return -1;
+		}
+		pipelineDemo(&pipeline, nullptr, &demo);
+	}
+	else if (recordPath != nullptr) {
+		if (!demoBegin(&demo, engine, mapPath)) {
+			glfwTerminate();
+			return -1;
+		}
+		pipelineDemo(&pipeline, &demo, nullptr);
+	}
+	if (shareName != nullptr && !frameShareCreate(&share, shareName)) {
+		glfwTerminate();
+		return -1;
+	}
+	if (servePort >= 0) {
+		if (!streamServerStart(&server, servePort)) {
+			frameShareClose(&share);
+			glfwTerminate();
+			return -1;
+		}
+		std::cout << "Serving frames on port " << server.port << std::endl;
+	}
+	// the window never waits for the writer, frames it cannot keep up with are dropped
+	if (capturePath != nullptr && !captureOpen(&capture, capturePath, captureFormat, true)) {
+		frameShareClose(&share);
+		streamServerStop(&server);
+		glfwTerminate();
+		return -1;
+	}
+	viewMode = engine->view.renderMode;
+	columnMode = startColumns;
+	if (detailBudget > 0) {
+		// the controller starts at full detail and falls back to the mode asked for
+		detailInit(&detail, detailBudget * 1000000LL, (startColumns == COLUMNS_INTERLACED) ? COLUMNS_INTERLACED : COLUMNS_LOW);
+		columnMode = COLUMNS_FULL;
+		autoDetail = true;
+	}
+	if (!presentStart(window, &presentFrames, &inputLatency)) {
+		frameShareClose(&share);
+		streamServerStop(&server);
+		captureClose(&capture);
+		glfwTerminate();
+		return -1;
+	}
+	pipelinePresent(&pipeline, &presentFrames);
+	pipelineStart(&pipeline, engine);
 
 	while (!glfwWindowShouldClose(window)) {
 		// display window content
 		display(window);
 
-		// poll IO events
-		glfwPollEvents();
+		// the swap is on the present thread now, so sleep until the next frame is due or input arrives
+		int wait = 50 - (engine->frameTime.frame1 - engine->frameTime.frame2);
+		if (wait > 0) {
+			glfwWaitEventsTimeout(wait / 1000.0);
+		}
+		else {
+			glfwPollEvents();
+		}
 	}
 
+	pipelineStop(&pipeline);
+	presentStop();
+	if (presentFrames.published > 0) {
+		std::cout << "Presented " << presentCount() << " of " << presentFrames.published << " frames, " << presentFrames.dropped << " replaced before the swap" << std::endl;
+	}
+	frameShareClose(&share);
+	streamServerStop(&server);
+	if (capturePath != nullptr) {
+		if (captureClose(&capture)) {
+			std::cout << "Captured " << capture.written << " frames to " << capturePath << ", dropped " << capture.dropped << std::endl;
+		}
+		else {
+			std::cout << "Failed to write " << capturePath << std::endl;
+		}
+	}
+	if (recordPath != nullptr) {
+		if (demoWrite(&demo, recordPath)) {
+			std::cout << "Wrote " << recordPath << ", " << demo.numTicks << " ticks" << std::endl;
+		}
+		else {
+			std::cout << "Failed to write " << recordPath << std::endl;
+		}
+	}
+
+	// report input to present latency
+	if (inputLatency.count > 0) {
+		std::cout << "Input latency: " << latencyAverage(&inputLatency) / 1000000.0 << " ms average of the last " << latencySamples
+			<< " frames with input, " << inputLatency.worst / 1000000.0 << " ms worst" << std::endl;
+	}
+	if (pipeline.input.dropped > 0) {
+		std::cout << "Input queue dropped " << pipeline.input.dropped << " events" << std::endl;
+	}
+
+	// report how much per-frame scratch memory was needed
+	std::cout << "Frame arena high-water mark: " << engine->view.frameArena.highWater << " of " << engine->view.frameArena.capacity << " bytes" << std::endl;
+	if (engine->view.frameArena.overflow > 0) {
+		std::cout << "Frame arena overflowed by " << engine->view.frameArena.overflow << " bytes, raise frameArenaSize" << std::endl;
+	}
+	destroyEngine(engine);
+
 	// terminate all glfw resources
 	glfwTerminate();
 	return 0;
-}
\ No newline at end of file
+}
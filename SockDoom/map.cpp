@@ -0,0 +1,204 @@
+#include "map.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+int loadSectors[] = {
+	// wall start, wall end, z1 (bottom of wall) height, z2 (top of wall) height, bottom color, top color
+	 0,  4,  0, 40,  2,  3,  // sector 1
+	 4,  8,  0, 40,  4,  5,  // sector 2
+	 8, 12,  0, 40,  6,  7,  // sector 3
+    12, 16,  0, 40,  0,  1,  // sector 4
+};
+
+int loadStart[] = {
+	// x, y, z, angle, look of the player
+	70, -110, 20, 0, 0,
+};
+
+int loadWalls[] = {
+	// x1, y1, x2, y2, color
+	 0,  0, 32,  0,  0,
+	32,  0, 32, 32,  1,
+	32, 32,  0, 32,  0,
+	 0, 32,  0,  0,  1,
+
+	64,  0, 96,  0,  2,
+	96,  0, 96, 32,  3,
+	96, 32, 64, 32,  2,
+	64, 32, 64,  0,  3,
+
+	64, 64, 96, 64,  4,
+	96, 64, 96, 96,  5,
+	96, 96, 64, 96,  4,
+	64, 96, 64, 64,  5,
+
+	 0, 64, 32, 64,  6,
+	32, 64, 32, 96,  7,
+	32, 96,  0, 96,  6,
+	 0, 96,  0, 64,  7,
+};
+
+// maps loaded from files by path, kept only while some engine still uses them
+static std::mutex mapCacheLock;
+static std::map<std::string, std::weak_ptr<const MapData>> mapCache;
+
+std::shared_ptr<const MapData> buildMap(const int* sectorData, int sectorCount, const int* wallData, int wallCount, const int start[5]) {
+	int s, w;
+
+	if (sectorCount < 0 || sectorCount > maxSect || wallCount < 0 || wallCount > maxWall) {
+		std::cout << "Map has " << sectorCount << " sectors and " << wallCount << " walls, the limit is " << maxSect << " and " << maxWall << std::endl;
+		return nullptr;
+	}
+	for (s = 0; s < sectorCount; s++) {
+		int wallStart = sectorData[s * 6 + 0];
+		int wallEnd = sectorData[s * 6 + 1];
+		if (wallStart < 0 || wallEnd <= wallStart || wallEnd > wallCount) {
+			std::cout << "Sector " << s << " has an invalid wall range " << wallStart << "-" << wallEnd << std::endl;
+			return nullptr;
+		}
+	}
+
+	std::shared_ptr<MapData> map = std::make_shared<MapData>();
+
+	// load sectors
+	int v1 = 0;
+	for (s = 0; s < sectorCount; s++) {
+		// wall start number
+		map->sectors[s].wallStart = sectorData[v1 + 0];
+		// wall end number
+		map->sectors[s].wallEnd = sectorData[v1 + 1];
+		// sector bottom height
+		map->sectors[s].z1 = sectorData[v1 + 2];
+		// sector top height
+		map->sectors[s].z2 = sectorData[v1 + 3] - sectorData[v1 + 2];
+		// sector bottom color
+		map->sectors[s].colorBot = sectorData[v1 + 4];
+		// sector top color
+		map->sectors[s].colorTop = sectorData[v1 + 5];
+		v1 += 6;
+	}
+
+	// load walls
+	int v2 = 0;
+	for (w = 0; w < wallCount; w++) {
+		// bottom x1
+		map->walls[w].x1 = wallData[v2 + 0];
+		// bottom y1
+		map->walls[w].y1 = wallData[v2 + 1];
+		// top x2
+		map->walls[w].x2 = wallData[v2 + 2];
+		// top y2
+		map->walls[w].y2 = wallData[v2 + 3];
+		// wall color
+		map->walls[w].color = wallData[v2 + 4];
+		v2 += 5;
+	}
+
+	map->numSect = sectorCount;
+	map->numWall = wallCount;
+	for (s = 0; s < 5; s++) {
+		map->start[s] = start[s];
+	}
+	if (!buildBlockmap(map.get()) || !buildSectorMap(map.get())) {
+		return nullptr;
+	}
+	return map;
+}
+
+// read the next integer of a map file, skipping # comments
+static bool readMapInt(FILE* file, int* value) {
+	int c;
+
+	while ((c = fgetc(file)) != EOF) {
+		if (c == '#') {
+			while ((c = fgetc(file)) != EOF && c != '\n') {
+			}
+		}
+		else if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+			ungetc(c, file);
+			return fscanf(file, "%d", value) == 1;
+		}
+	}
+	return false;
+}
+
+// read the next keyword of a map file, skipping # comments
+static bool readMapWord(FILE* file, const char* word) {
+	char text[16];
+	int c;
+
+	while ((c = fgetc(file)) != EOF) {
+		if (c == '#') {
+			while ((c = fgetc(file)) != EOF && c != '\n') {
+			}
+		}
+		else if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+			ungetc(c, file);
+			return fscanf(file, "%15s", text) == 1 && strcmp(text, word) == 0;
+		}
+	}
+	return false;
+}
+
+// parse a .map file into a new map
+static std::shared_ptr<const MapData> parseMapFile(const char* path) {
+	// heap buffers, since several engines can load maps at once
+	std::unique_ptr<int[]> sectorData(new int[maxSect * 6]);
+	std::unique_ptr<int[]> wallData(new int[maxWall * 5]);
+	int start[5];
+	int sectorCount, wallCount;
+	int i;
+
+	FILE* file = fopen(path, "r");
+	if (file == nullptr) {
+		std::cout << "Failed to open map " << path << std::endl;
+		return nullptr;
+	}
+
+	bool ok = readMapWord(file, "player");
+	for (i = 0; ok && i < 5; i++) {
+		ok = readMapInt(file, &start[i]);
+	}
+	ok = ok && readMapWord(file, "sectors") && readMapInt(file, &sectorCount) && sectorCount >= 0 && sectorCount <= maxSect;
+	for (i = 0; ok && i < sectorCount * 6; i++) {
+		ok = readMapInt(file, &sectorData[i]);
+	}
+	ok = ok && readMapWord(file, "walls") && readMapInt(file, &wallCount) && wallCount >= 0 && wallCount <= maxWall;
+	for (i = 0; ok && i < wallCount * 5; i++) {
+		ok = readMapInt(file, &wallData[i]);
+	}
+	fclose(file);
+
+	if (!ok) {
+		std::cout << "Failed to parse map " << path << std::endl;
+		return nullptr;
+	}
+	return buildMap(sectorData.get(), sectorCount, wallData.get(), wallCount, start);
+}
+
+std::shared_ptr<const MapData> loadMapFile(const char* path) {
+	// held for the whole load so engines asking for the same map at once parse it only once
+	std::lock_guard<std::mutex> guard(mapCacheLock);
+
+	std::shared_ptr<const MapData> map = mapCache[path].lock();
+	if (map == nullptr) {
+		map = parseMapFile(path);
+		if (map == nullptr) {
+			mapCache.erase(path);
+			return nullptr;
+		}
+		mapCache[path] = map;
+	}
+	return map;
+}
+
+std::shared_ptr<const MapData> builtInMap() {
+	// built on first use; function statics are initialized once even with several threads
+	static std::shared_ptr<const MapData> map = buildMap(loadSectors, 4, loadWalls, 16, loadStart);
+	return map;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <memory>
+
+#include "blockmap.h"
+#include "sectormap.h"
+#include "types.h"
+
+// a loaded map and its lookup grids; never changed once built, so any number of engines on any
+// threads can share one
+struct MapData {
+	Wall walls[maxWall];
+	Sector sectors[maxSect];
+	// number of sectors and walls
+	int numSect, numWall;
+	// x, y, z, angle, look of the player at the start
+	int start[5];
+	Blockmap blockmap;
+	SectorMap sectorMap;
+};
+
+// build a map from sectors and walls in the same layout as loadSectors and loadWalls,
+// nullptr if they are invalid
+std::shared_ptr<const MapData> buildMap(const int* sectorData, int sectorCount, const int* wallData, int wallCount, const int start[5]);
+// load a .map file, see maps/default.map for the format; loading a path that is already loaded
+// shares the same map, nullptr if the file is missing or invalid
+std::shared_ptr<const MapData> loadMapFile(const char* path);
+// the built-in map, built once and shared
+std::shared_ptr<const MapData> builtInMap();
@@ -0,0 +1,186 @@
+#include "overlay.h"
+
+#include "profiler.h"
+#include "render.h"
+
+// 3x5 glyphs, 3 bits per row from the top
+const char overlayChars[] = "0123456789.ACDILOPRUVWX";
+
+int overlayFont[][5] = {
+	{7, 5, 5, 5, 7},  // 0
+	{2, 6, 2, 2, 7},  // 1
+	{7, 1, 7, 4, 7},  // 2
+	{7, 1, 7, 1, 7},  // 3
+	{5, 5, 7, 1, 1},  // 4
+	{7, 4, 7, 1, 7},  // 5
+	{7, 4, 7, 5, 7},  // 6
+	{7, 1, 1, 1, 1},  // 7
+	{7, 5, 7, 5, 7},  // 8
+	{7, 5, 7, 1, 7},  // 9
+	{0, 0, 0, 0, 2},  // .
+	{2, 5, 7, 5, 5},  // A
+	{3, 4, 4, 4, 3},  // C
+	{6, 5, 5, 5, 6},  // D
+	{7, 2, 2, 2, 7},  // I
+	{4, 4, 4, 4, 7},  // L
+	{7, 5, 5, 5, 7},  // O
+	{6, 5, 6, 4, 4},  // P
+	{6, 5, 6, 5, 5},  // R
+	{5, 5, 5, 5, 7},  // U
+	{5, 5, 5, 5, 2},  // V
+	{5, 5, 7, 7, 5},  // W
+	{5, 5, 2, 5, 5},  // X
+};
+
+// color of each profile stage in the overlay
+int stageColors[STAGE_COUNT] = { 9, 4, 2, 0, 6, 10, 11 };
+
+// draw one glyph from overlayFont with its top left corner at x/y
+void drawGlyph(View* view, int x, int y, int glyph, int color) {
+	int row, col;
+
+	for (row = 0; row < 5; row++) {
+		for (col = 0; col < 3; col++) {
+			if ((overlayFont[glyph][row] >> (2 - col)) & 1) {
+				pixel(view, x + col, y - row, color);
+			}
+		}
+	}
+}
+
+// draw a string of overlayChars, returns x after the last glyph
+int drawText(View* view, int x, int y, const char* text, int color) {
+	int glyph;
+
+	for (; *text != '\0'; text++) {
+		for (glyph = 0; overlayChars[glyph] != '\0'; glyph++) {
+			if (overlayChars[glyph] == *text) {
+				drawGlyph(view, x, y, glyph, color);
+				break;
+			}
+		}
+		x += 4;
+	}
+	return x;
+}
+
+// draw value/100 with two decimals, returns x after the last glyph
+int drawNumber(View* view, int x, int y, int value, int color) {
+	int digits[10];
+	int numDigits = 0;
+	int i;
+
+	if (value < 0) {
+		value = 0;
+	}
+	// always print at least 0.00
+	do {
+		digits[numDigits++] = value % 10;
+		value /= 10;
+	} while (value > 0 || numDigits < 3);
+
+	for (i = numDigits - 1; i >= 0; i--) {
+		drawGlyph(view, x, y, digits[i], color);
+		x += 4;
+		if (i == 2) {
+			drawGlyph(view, x - 1, y, 10, color);
+			x += 2;
+		}
+	}
+	return x;
+}
+
+// draw an integer, returns x after the last glyph
+int drawInt(View* view, int x, int y, int value, int color) {
+	char text[12];
+	int length = 0;
+	int i;
+
+	if (value < 0) {
+		value = 0;
+	}
+	do {
+		text[length++] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+
+	for (i = length - 1; i >= 0; i--) {
+		char c[2] = { text[i], '\0' };
+		x = drawText(view, x, y, c, color);
+	}
+	return x;
+}
+
+// draw last frame's render statistics as labelled rows starting at y
+void drawStatsOverlay(View* view, int y) {
+	const char* labels[6] = { "WALL", "CULL", "CLIP", "COL", "PIX", "OVR" };
+	int values[6];
+	int i;
+
+	values[0] = view->lastStats.wallsConsidered;
+	values[1] = view->lastStats.wallsCulled;
+	values[2] = view->lastStats.wallsClipped;
+	values[3] = view->lastStats.columns;
+	values[4] = statsPixelsWritten(&view->lastStats);
+
+	for (i = 0; i < 5; i++) {
+		drawText(view, 2, y, labels[i], 9);
+		drawInt(view, 22, y, values[i], 9);
+		y -= 7;
+	}
+	// overdraw ratio with two decimals
+	drawText(view, 2, y, labels[5], 9);
+	drawNumber(view, 22, y, statsOverdraw(&view->lastStats, SW * SH), 9);
+}
+
+// draw per-stage timings and a stacked frame time graph into the top left corner
+void drawOverlay(View* view) {
+	int s, f, x, y;
+	// timings go to the right of the statistics when those are compiled in
+	int statsX = statsEnabled ? 48 : 0;
+
+	// one row per stage: color swatch, average milliseconds and a bar at 4 pixels per millisecond
+	for (s = 0; s < STAGE_COUNT; s++) {
+		int top = SH - 2 - s * 7;
+		int64_t average = profilerAverage(s, 32);
+
+		for (y = 0; y < 5; y++) {
+			for (x = 0; x < 3; x++) {
+				pixel(view, statsX + 2 + x, top - y, stageColors[s]);
+			}
+		}
+		drawNumber(view, statsX + 7, top, static_cast<int>(average / 10000), 9);
+
+		int length = static_cast<int>(average * 4 / 1000000);
+		if (length > SW - statsX - 32) {
+			length = SW - statsX - 32;
+		}
+		for (x = 0; x < length; x++) {
+			pixel(view, statsX + 30 + x, top - 1, stageColors[s]);
+			pixel(view, statsX + 30 + x, top - 2, stageColors[s]);
+			pixel(view, statsX + 30 + x, top - 3, stageColors[s]);
+		}
+	}
+
+	// stacked graph of recent frames at 1 pixel per millisecond, newest on the right
+	int base = SH - 2 - STAGE_COUNT * 7 - 42;
+	int numFrames = profilerFrameCount();
+	if (numFrames > 64) {
+		numFrames = 64;
+	}
+	for (f = 0; f < numFrames; f++) {
+		const ProfileFrame* frame = profilerFrame(f);
+		x = statsX + 2 + 63 - f;
+		y = base;
+		for (s = 1; s < STAGE_COUNT; s++) {
+			int height = static_cast<int>(frame->stageTime[s] / 1000000);
+			while (height-- > 0 && y < base + 40) {
+				pixel(view, x, y++, stageColors[s]);
+			}
+		}
+	}
+
+	if (statsEnabled) {
+		drawStatsOverlay(view, SH - 2);
+	}
+}
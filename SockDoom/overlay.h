@@ -0,0 +1,12 @@
+#pragma once
+
+struct View;
+
+// draw a string of digits, '.' and the capitals in the overlay font, returns x after the last glyph
+int drawText(View* view, int x, int y, const char* text, int color);
+// draw value/100 with two decimals, returns x after the last glyph
+int drawNumber(View* view, int x, int y, int value, int color);
+// draw an integer, returns x after the last glyph
+int drawInt(View* view, int x, int y, int value, int color);
+// draw per-stage timings, a stacked frame time graph and render statistics into the top left corner
+void drawOverlay(View* view);
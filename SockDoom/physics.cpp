@@ -0,0 +1,44 @@
+#include "physics.h"
+
+#include "map.h"
+
+void sectorSpan(const MapData* map, int s, int z, int* floor, int* ceiling) {
+	*floor = groundHeight;
+	*ceiling = noCeiling;
+	if (s < 0) {
+		return;
+	}
+
+	int bottom = map->sectors[s].z1;
+	int top = map->sectors[s].z1 + map->sectors[s].z2;
+	// anything from a step below the top up stands on the sector, anything inside it is pushed on top
+	if (z >= top - stepHeight || z >= bottom) {
+		*floor = top;
+	}
+	else {
+		*ceiling = bottom;
+	}
+}
+
+bool fallMove(int* z, int* velZ, int floor, int ceiling, int height) {
+	*velZ -= gravity;
+	if (*velZ < -maxFallSpeed) {
+		*velZ = -maxFallSpeed;
+	}
+	*z += *velZ;
+
+	// bump the head first, so a gap too low to fit in still leaves the feet on the floor
+	if (*z + height > ceiling) {
+		*z = ceiling - height;
+		if (*velZ > 0) {
+			*velZ = 0;
+		}
+	}
+	// landing or stepping up onto a ledge
+	if (*z <= floor) {
+		*z = floor;
+		*velZ = 0;
+		return true;
+	}
+	return false;
+}
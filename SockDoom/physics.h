@@ -0,0 +1,20 @@
+#pragma once
+
+struct MapData;
+
+// defines for vertical movement, in world units and simulation ticks
+#define gravity            1                       // fall speed gained each tick
+#define maxFallSpeed       16                      // fastest fall speed
+#define jumpSpeed          6                       // upward speed of a jump
+#define stepHeight         12                      // tallest ledge that can be walked onto
+#define eyeHeight          20                      // height of the camera above the feet
+#define playerHeight       28                      // height of the player's body
+#define groundHeight       0                       // floor height outside every sector
+#define noCeiling          0x3fffffff              // ceiling height where nothing is overhead
+
+// floor and ceiling for something with its feet at height z inside sector s (-1 for open ground):
+// sectors are solid from z1 to z1 + z2, so they are stood on or walked under
+void sectorSpan(const MapData* map, int s, int z, int* floor, int* ceiling);
+// one tick of gravity for something of the given height, clamped between floor and ceiling,
+// returns true if it is standing on the floor
+bool fallMove(int* z, int* velZ, int floor, int ceiling, int height);
@@ -0,0 +1,234 @@
+#include "pipeline.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "actor.h"
+#include "overlay.h"
+#include "profiler.h"
+#include "render.h"
+
+static void stageLoop(PipelineStage* stage, int thread) {
+	profileSetThread(thread);
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> guard(stage->lock);
+			stage->cv.wait(guard, [stage] { return stage->busy || stage->quit; });
+			if (stage->quit) {
+				return;
+			}
+		}
+		stage->work(stage->pipeline);
+		{
+			std::lock_guard<std::mutex> guard(stage->lock);
+			stage->busy = false;
+		}
+		stage->cv.notify_all();
+	}
+}
+
+static void startStage(PipelineStage* stage, Pipeline* pipeline, void (*work)(Pipeline*), int thread) {
+	stage->busy = false;
+	stage->quit = false;
+	stage->work = work;
+	stage->pipeline = pipeline;
+	stage->thread = std::thread(stageLoop, stage, thread);
+}
+
+static void kickStage(PipelineStage* stage) {
+	{
+		std::lock_guard<std::mutex> guard(stage->lock);
+		stage->busy = true;
+	}
+	stage->cv.notify_all();
+}
+
+static void waitStage(PipelineStage* stage) {
+	std::unique_lock<std::mutex> guard(stage->lock);
+	stage->cv.wait(guard, [stage] { return !stage->busy; });
+}
+
+static void stopStage(PipelineStage* stage) {
+	waitStage(stage);
+	{
+		std::lock_guard<std::mutex> guard(stage->lock);
+		stage->quit = true;
+	}
+	stage->cv.notify_all();
+	stage->thread.join();
+}
+
+// simulation thread: advance the world one tick and snapshot it into the free state
+static void simulate(Pipeline* pipeline) {
+	Engine* engine = pipeline->engine;
+	FrameState* states = pipeline->states;
+	int next = 1 - pipeline->renderState;
+
+	{
+		PROFILE_SCOPE(STAGE_MOVE);
+		inputTick(&pipeline->input, &pipeline->heldKeys, &engine->keys, &states[next].inputTime);
+		if (pipeline->playDemo != nullptr) {
+			// the demo replaces the keyboard, and stands still once it runs out
+			int tick = states[pipeline->renderState].tick;
+			pipeline->demoDone = tick >= pipeline->playDemo->numTicks;
+			if (pipeline->demoDone) {
+				engine->keys = Keys();
+			}
+			else {
+				unpackKeys(pipeline->playDemo->ticks[tick], &engine->keys);
+			}
+		}
+		if (pipeline->recordDemo != nullptr && !demoRecordTick(pipeline->recordDemo, &engine->keys)) {
+			std::cout << "Demo is full after " << maxDemoTicks << " ticks, recording stopped" << std::endl;
+			pipeline->recordDemo = nullptr;
+		}
+		movePlayer(engine);
+		thinkActors(engine);
+		moveActors(engine);
+	}
+
+	states[next].tick = states[pipeline->renderState].tick + 1;
+	states[next].camera = engine->player;
+	states[next].overlay = 0;
+	states[next].mode = RENDER_NORMAL;
+	states[next].columns = COLUMNS_FULL;
+}
+
+// render thread: draw a state and keep the frame for the main thread
+static void render(Pipeline* pipeline) {
+	Engine* engine = pipeline->engine;
+	TripleBuffer* presentTarget = pipeline->presentTarget;
+	const FrameState* state = &pipeline->states[pipeline->renderState];
+	int64_t start = profileNow();
+
+	engine->view.renderMode = state->mode;
+	engine->view.columnMode = state->columns;
+	if (presentTarget != nullptr) {
+		// draw straight into the present thread's free buffer
+		engine->view.frameBuffer = tripleBack(presentTarget);
+	}
+	resetRenderStats(&engine->view.renderStats);
+	{
+		PROFILE_SCOPE(STAGE_CLEAR);
+		clearBackground(&engine->view);
+	}
+	draw3D(engine, &state->camera);
+	engine->view.lastStats = engine->view.renderStats;
+	if (engine->view.renderMode == RENDER_OVERDRAW) {
+		resolveOverdraw(&engine->view);
+	}
+	if (state->overlay) {
+		// the overlay itself is drawn in color on top of any heatmap
+		int mode = engine->view.renderMode;
+		engine->view.renderMode = RENDER_NORMAL;
+		drawOverlay(&engine->view);
+		engine->view.renderMode = mode;
+	}
+	memcpy(pipeline->frames[pipeline->renderFrame], engine->view.frameBuffer, SW * SH);
+	if (presentTarget != nullptr) {
+		triplePublish(presentTarget, state->inputTime);
+		engine->view.frameBuffer = engine->view.frameStorage;
+	}
+
+	// release this frame's scratch memory
+	arenaReset(&engine->view.frameArena);
+	pipeline->renderTime = profileNow() - start;
+}
+
+void pipelineInit(Pipeline* pipeline) {
+	pipeline->running = false;
+	pipeline->engine = nullptr;
+	pipeline->inFlight = false;
+	pipeline->recordDemo = nullptr;
+	pipeline->playDemo = nullptr;
+	pipeline->demoDone = false;
+	pipeline->presentTarget = nullptr;
+	pipeline->renderTime = 0;
+	inputClear(&pipeline->input);
+}
+
+void pipelineDemo(Pipeline* pipeline, Demo* record, const Demo* play) {
+	pipeline->recordDemo = record;
+	pipeline->playDemo = play;
+	pipeline->demoDone = false;
+}
+
+void pipelinePresent(Pipeline* pipeline, TripleBuffer* target) {
+	pipeline->presentTarget = target;
+}
+
+bool pipelineDemoDone(const Pipeline* pipeline) {
+	return pipeline->demoDone;
+}
+
+void pipelineStart(Pipeline* pipeline, Engine* target) {
+	FrameState* states = pipeline->states;
+
+	pipeline->engine = target;
+	states[0].tick = 0;
+	states[0].camera = target->player;
+	states[0].overlay = 0;
+	states[0].mode = RENDER_NORMAL;
+	states[0].columns = COLUMNS_FULL;
+	states[0].inputTime = 0;
+	pipeline->heldKeys = Keys();
+	inputClear(&pipeline->input);
+	pipeline->newestState = 0;
+	pipeline->newestFrame = 0;
+	pipeline->inFlight = false;
+	pipeline->renderState = 0;
+	pipeline->renderFrame = 0;
+	pipeline->renderTime = 0;
+	memset(pipeline->frames, 0, sizeof(pipeline->frames));
+
+	startStage(&pipeline->simStage, pipeline, simulate, 1);
+	startStage(&pipeline->renderStage, pipeline, render, 2);
+	pipeline->running = true;
+}
+
+void pipelineStop(Pipeline* pipeline) {
+	if (!pipeline->running) {
+		return;
+	}
+	pipelineWait(pipeline);
+	stopStage(&pipeline->simStage);
+	stopStage(&pipeline->renderStage);
+	pipeline->running = false;
+}
+
+void pipelineWait(Pipeline* pipeline) {
+	if (!pipeline->inFlight) {
+		return;
+	}
+	waitStage(&pipeline->simStage);
+	waitStage(&pipeline->renderStage);
+	// the frame just rendered is now the newest, as is the state just simulated
+	pipeline->newestFrame = pipeline->renderFrame;
+	pipeline->newestState = 1 - pipeline->renderState;
+	pipeline->inFlight = false;
+}
+
+void pipelineKick(Pipeline* pipeline, int overlay, int mode, int columns) {
+	// the render thread draws the newest state while the simulation writes the other one
+	pipeline->renderState = pipeline->newestState;
+	pipeline->renderFrame = 1 - pipeline->newestFrame;
+	pipeline->states[pipeline->renderState].overlay = overlay;
+	pipeline->states[pipeline->renderState].mode = mode;
+	pipeline->states[pipeline->renderState].columns = columns;
+
+	pipeline->inFlight = true;
+	kickStage(&pipeline->renderStage);
+	kickStage(&pipeline->simStage);
+}
+
+const unsigned char* pipelineFrame(const Pipeline* pipeline) {
+	return pipeline->frames[pipeline->newestFrame];
+}
+
+const FrameState* pipelineFrameState(const Pipeline* pipeline) {
+	return &pipeline->states[1 - pipeline->newestState];
+}
+
+int64_t pipelineRenderTime(const Pipeline* pipeline) {
+	return pipeline->renderTime;
+}
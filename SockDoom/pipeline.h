@@ -0,0 +1,106 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "demo.h"
+#include "engine.h"
+#include "input.h"
+#include "triplebuffer.h"
+
+// what the simulation hands to the renderer after each tick; the renderer only reads it
+struct FrameState {
+	// ticks simulated to reach this state
+	int tick;
+	// pose of the camera
+	Player camera;
+	// show the profiler overlay on this frame
+	int overlay;
+	// render mode of this frame
+	int mode;
+	// column mode of this frame
+	int columns;
+	// profileNow() of the oldest input event the tick applied, 0 if there was none
+	int64_t inputTime;
+};
+
+struct Pipeline;
+
+// a thread that runs one piece of work each time it is kicked
+struct PipelineStage {
+	std::thread thread;
+	std::mutex lock;
+	std::condition_variable cv;
+	// set by kick, cleared when the work is done
+	bool busy;
+	bool quit;
+	void (*work)(Pipeline*);
+	Pipeline* pipeline;
+};
+
+// the window loop runs three stages of one engine at once: the simulation thread runs tick N + 1
+// while the render thread draws the state of tick N and the main thread hands out the frame of tick N - 1.
+// states and finished frames are double buffered, so no stage waits on another until
+// pipelineWait() at the start of the next frame.
+// the caller owns the pipeline, so each engine can run in a pipeline of its own
+struct Pipeline {
+	PipelineStage simStage;
+	PipelineStage renderStage;
+	bool running;
+	// engine being simulated and rendered, set by pipelineStart()
+	Engine* engine;
+	// a frame was kicked and not waited for yet
+	bool inFlight;
+
+	// window thread pushes key events here, the simulation applies them at its next tick
+	InputQueue input;
+	// states written by the simulation, the renderer reads the other one
+	FrameState states[2];
+	// frames written by the renderer, the main thread hands out the other one
+	unsigned char frames[2][SW * SH];
+	// keys held down between ticks, only used by the simulation thread
+	Keys heldKeys;
+	// demos being recorded and played, and whether playback has run out; set before the threads start
+	Demo* recordDemo;
+	const Demo* playDemo;
+	bool demoDone;
+	// frames are also published here when set
+	TripleBuffer* presentTarget;
+	// index of the newest state and the newest finished frame
+	int newestState;
+	int newestFrame;
+	// state being rendered and frame being written by the render thread
+	int renderState;
+	int renderFrame;
+	// how long the render thread took over its last frame
+	int64_t renderTime;
+};
+
+// no engine, demo or present target, and not running; once before the other calls
+void pipelineInit(Pipeline* pipeline);
+// record the keys of every tick into record and/or take them from play instead of the input queue,
+// nullptr for neither; set before pipelineStart()
+void pipelineDemo(Pipeline* pipeline, Demo* record, const Demo* play);
+// also hand every finished frame to target as soon as it is drawn, stamped with its inputTime, so a
+// present thread can show it without waiting for the main thread; nullptr for none, set before pipelineStart()
+void pipelinePresent(Pipeline* pipeline, TripleBuffer* target);
+// true once every tick of the demo being played has run, check after pipelineWait()
+bool pipelineDemoDone(const Pipeline* pipeline);
+// empty the input queue and start the simulation and render threads on an engine, the first frame
+// shows its current player; the engine belongs to the pipeline until pipelineStop()
+void pipelineStart(Pipeline* pipeline, Engine* target);
+// finish the frame in flight and join both threads
+void pipelineStop(Pipeline* pipeline);
+// wait until the simulation and render threads finish their frame
+void pipelineWait(Pipeline* pipeline);
+// render the newest state with the overlay, render mode and column mode given, and simulate the
+// next tick from the events in the pipeline's input queue, each on its own thread
+void pipelineKick(Pipeline* pipeline, int overlay, int mode, int columns);
+// newest finished frame as palette colors, row 0 is the bottom; valid until the next pipelineWait()
+const unsigned char* pipelineFrame(const Pipeline* pipeline);
+// state the newest finished frame was drawn from; valid until the next pipelineKick()
+const FrameState* pipelineFrameState(const Pipeline* pipeline);
+// nanoseconds the render thread spent on the newest finished frame
+int64_t pipelineRenderTime(const Pipeline* pipeline);
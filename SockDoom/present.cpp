@@ -0,0 +1,263 @@
+#include "present.h"
+
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "input.h"
+#include "profiler.h"
+#include "render.h"
+
+// profileSetThread() number of the present thread, after the simulation and render threads
+#define presentThread      3
+
+// one triangle that covers the screen, made from the vertex number alone so no vertex buffer is needed
+static const char* vertexSource =
+	"#version 330 core\n"
+	"void main() {\n"
+	"	vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);\n"
+	"	gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);\n"
+	"}\n";
+
+// each window pixel looks up the frame pixel it scales up from and that pixel's palette color,
+// anything outside the scaled frame is black
+static const char* fragmentSource =
+	"#version 330 core\n"
+	"uniform usampler2D frame;\n"
+	"uniform sampler2D palette;\n"
+	"uniform int scale;\n"
+	"uniform ivec2 offset;\n"
+	"out vec4 color;\n"
+	"void main() {\n"
+	"	ivec2 pixel = ivec2(gl_FragCoord.xy) - offset;\n"
+	"	if (any(lessThan(pixel, ivec2(0))) || any(greaterThanEqual(pixel, textureSize(frame, 0) * scale))) {\n"
+	"		color = vec4(0.0, 0.0, 0.0, 1.0);\n"
+	"		return;\n"
+	"	}\n"
+	"	uint index = texelFetch(frame, pixel / scale, 0).r;\n"
+	"	color = texelFetch(palette, ivec2(int(index), 0), 0);\n"
+	"}\n";
+
+static std::thread thread;
+static GLFWwindow* presentWindow = nullptr;
+static TripleBuffer* source = nullptr;
+static InputLatency* inputLatency = nullptr;
+static std::atomic<long long> presented(0);
+// framebuffer size of the window, the frame is scaled up by a whole number to fit and centered
+static int windowWidth, windowHeight;
+static int frameScale;
+// the frame as one palette index per texel, the 256 palette colors, and the two pixel buffers
+// uploads alternate between
+static GLuint frameTexture, paletteTexture;
+static GLuint pixelBuffers[2];
+static int nextBuffer;
+static GLuint program, vertexArray;
+
+// compile one shader, 0 if it fails
+static GLuint compileShader(GLenum type, const char* text) {
+	GLint ok;
+	char log[1024];
+	GLuint shader = glCreateShader(type);
+
+	glShaderSource(shader, 1, &text, nullptr);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+	if (!ok) {
+		glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+		std::cout << "Failed to compile present shader: " << log << std::endl;
+		glDeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+// build the shader, textures and pixel buffers in the current context and size them to window
+static bool initGL(GLFWwindow* window) {
+	int c;
+	GLint ok;
+	char log[1024];
+	unsigned char palette[256][4];
+
+	glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+	frameScale = (windowWidth / SW < windowHeight / SH) ? windowWidth / SW : windowHeight / SH;
+	if (frameScale < 1) {
+		frameScale = 1;
+	}
+
+	GLuint vertexShader = compileShader(GL_VERTEX_SHADER, vertexSource);
+	GLuint fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	if (vertexShader == 0 || fragmentShader == 0) {
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return false;
+	}
+	program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+	glGetProgramiv(program, GL_LINK_STATUS, &ok);
+	if (!ok) {
+		glGetProgramInfoLog(program, sizeof(log), nullptr, log);
+		std::cout << "Failed to link present shader: " << log << std::endl;
+		glDeleteProgram(program);
+		return false;
+	}
+	glUseProgram(program);
+	glUniform1i(glGetUniformLocation(program, "frame"), 0);
+	glUniform1i(glGetUniformLocation(program, "palette"), 1);
+	glUniform1i(glGetUniformLocation(program, "scale"), frameScale);
+	glUniform2i(glGetUniformLocation(program, "offset"), (windowWidth - SW * frameScale) / 2, (windowHeight - SH * frameScale) / 2);
+	// a core context draws nothing without a vertex array, even an empty one
+	glGenVertexArrays(1, &vertexArray);
+	glBindVertexArray(vertexArray);
+
+	for (c = 0; c < 256; c++) {
+		paletteColor(c, palette[c]);
+		palette[c][3] = 255;
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glGenTextures(1, &paletteTexture);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, paletteTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 256, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, palette);
+
+	// row 0 of the texture is the bottom of the screen, as it is in the frame
+	glGenTextures(1, &frameTexture);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, frameTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, SW, SH, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+
+	glGenBuffers(2, pixelBuffers);
+	for (c = 0; c < 2; c++) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[c]);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, SW * SH, nullptr, GL_STREAM_DRAW);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	nextBuffer = 0;
+	glViewport(0, 0, windowWidth, windowHeight);
+	return true;
+}
+
+static void freeGL() {
+	glDeleteBuffers(2, pixelBuffers);
+	glDeleteTextures(1, &frameTexture);
+	glDeleteTextures(1, &paletteTexture);
+	glDeleteVertexArrays(1, &vertexArray);
+	glDeleteProgram(program);
+}
+
+// copy a frame into the texture as it is, the shader expands the palette
+static void uploadFrame(const unsigned char* frame) {
+	// the other buffer may still be feeding the last upload, this one finished a frame ago;
+	// invalidating it first means mapping never waits for the GPU either way
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[nextBuffer]);
+	void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, SW * SH, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+	if (mapped != nullptr) {
+		memcpy(mapped, frame, SW * SH);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		// with a pixel buffer bound the pointer is an offset into it
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, SW, SH, GL_RED_INTEGER, GL_UNSIGNED_BYTE, nullptr);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	nextBuffer = 1 - nextBuffer;
+}
+
+static void drawFrame() {
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+static void presentLoop() {
+	profileSetThread(presentThread);
+	glfwMakeContextCurrent(presentWindow);
+	// the swap waits for vsync here instead of holding up the frames behind it
+	glfwSwapInterval(1);
+
+	while (tripleWait(source, presentPoll) || !tripleClosed(source)) {
+		if (!tripleTake(source)) {
+			continue;
+		}
+		int64_t inputTime = tripleStamp(source);
+		{
+			PROFILE_SCOPE(STAGE_SWAP);
+			uploadFrame(tripleFront(source));
+			drawFrame();
+			glfwSwapBuffers(presentWindow);
+		}
+		presented++;
+		// input latency runs up to the return of the swap, the display adds its own scanout time
+		if (inputTime != 0) {
+			latencyRecord(inputLatency, profileNow() - inputTime);
+		}
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
+
+bool presentStart(GLFWwindow* window, TripleBuffer* frames, InputLatency* latency) {
+	if (!initGL(window)) {
+		return false;
+	}
+	presentWindow = window;
+	source = frames;
+	inputLatency = latency;
+	tripleInit(frames);
+	presented = 0;
+	glfwMakeContextCurrent(nullptr);
+	thread = std::thread(presentLoop);
+	return true;
+}
+
+void presentStop() {
+	if (!thread.joinable()) {
+		return;
+	}
+	tripleClose(source);
+	thread.join();
+	glfwMakeContextCurrent(presentWindow);
+	freeGL();
+}
+
+long long presentCount() {
+	return presented;
+}
+
+int presentCheck(GLFWwindow* window, const unsigned char* frame) {
+	int x, y;
+	int mismatches = 0;
+	unsigned char rgb[3];
+
+	if (!initGL(window)) {
+		return -1;
+	}
+	uploadFrame(frame);
+	drawFrame();
+	std::vector<unsigned char> pixels(windowWidth * windowHeight * 4);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, windowWidth, windowHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+	int offsetX = (windowWidth - SW * frameScale) / 2, offsetY = (windowHeight - SH * frameScale) / 2;
+	for (y = 0; y < windowHeight; y++) {
+		for (x = 0; x < windowWidth; x++) {
+			int fx = x - offsetX, fy = y - offsetY;
+			if (fx < 0 || fy < 0 || fx >= SW * frameScale || fy >= SH * frameScale) {
+				rgb[0] = rgb[1] = rgb[2] = 0;
+			}
+			else {
+				paletteColor(frame[(fy / frameScale) * SW + fx / frameScale], rgb);
+			}
+			mismatches += memcmp(&pixels[(y * windowWidth + x) * 4], rgb, 3) != 0;
+		}
+	}
+	freeGL();
+	return mismatches;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+#include "input.h"
+#include "triplebuffer.h"
+
+struct GLFWwindow;
+
+// defines for present thread settings
+#define presentPoll        100                     // milliseconds the present thread waits for a frame at a time
+
+// a thread of its own owns the window's GL 3.3 core context: it takes the newest frame from a triple
+// buffer, uploads its palette indices through one of two pixel buffer objects so the copy to the GPU
+// does not stall on the previous upload, and swaps after one fullscreen triangle whose fragment shader
+// looks up the palette and scales the frame up by the largest whole number that fits the window.
+// the threads drawing frames never wait on the swap or vsync, and frames finished faster than the
+// display shows them are dropped.
+// the frame stamp is the profileNow() of the oldest input it includes, 0 if none, and the time from
+// there to the swap is added to the latency given to presentStart()
+
+// build the shader and textures in the GL context of window, current on the calling thread, then
+// release it, empty frames and start presenting from them, recording input latency into latency;
+// false if the shader does not build
+bool presentStart(GLFWwindow* window, TripleBuffer* frames, InputLatency* latency);
+// stop presenting, make the GL context current on the calling thread again and free the shader and textures
+void presentStop();
+// frames swapped to the window so far
+long long presentCount();
+
+// draw frame into window on the calling thread, whose GL context is current, and read it back;
+// returns how many window pixels differ from the frame scaled up on the CPU, -1 if the shader does not build
+int presentCheck(GLFWwindow* window, const unsigned char* frame);
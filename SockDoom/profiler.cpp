@@ -0,0 +1,246 @@
+#include "profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+
+// process start until profilerInit() is called, so timings are valid before it
+static std::chrono::steady_clock::time_point profileEpoch = std::chrono::steady_clock::now();
+static ProfileFrame frames[profileFrames];
+// total frames begun, the current frame is (frameNumber - 1) % profileFrames
+static int64_t frameNumber;
+static bool frameOpen;
+// guards the ring buffer, taken once per frame and never by profileRecord()
+static std::mutex frameLock;
+static thread_local int profileThread = 0;
+
+// events of one thread, written only by that thread and merged into the frame by profilerEndFrame()
+struct ProfileBuffer {
+	ProfileEvent events[profileRingEvents];
+	// events written and merged so far, the ring holds written - merged of them
+	std::atomic<int64_t> written;
+	std::atomic<int64_t> merged;
+	// running total of each stage, and the part of it already merged
+	std::atomic<int64_t> stageTotal[STAGE_COUNT];
+	int64_t stageMerged[STAGE_COUNT];
+	// cleared when the thread exits so the next new thread can take the buffer
+	std::atomic<bool> owned;
+};
+
+// every buffer ever made, guarded by bufferLock; buffers are reused but never freed
+static std::vector<ProfileBuffer*> buffers;
+static std::mutex bufferLock;
+
+// gives the buffer back when its thread exits
+struct ProfileBufferOwner {
+	ProfileBuffer* buffer = nullptr;
+	~ProfileBufferOwner() {
+		if (buffer != nullptr) {
+			buffer->owned.store(false, std::memory_order_release);
+		}
+	}
+};
+static thread_local ProfileBufferOwner bufferOwner;
+
+static const char* stageNames[STAGE_COUNT] = {
+	"frame",
+	"clearBackground",
+	"movePlayer",
+	"sort",
+	"transform",
+	"raster",
+	"swapBuffers",
+};
+
+static ProfileBuffer* threadBuffer() {
+	if (bufferOwner.buffer != nullptr) {
+		return bufferOwner.buffer;
+	}
+	// once per thread
+	std::lock_guard<std::mutex> guard(bufferLock);
+	ProfileBuffer* buffer = nullptr;
+	for (ProfileBuffer* b : buffers) {
+		bool expected = false;
+		if (b->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+			buffer = b;
+			break;
+		}
+	}
+	if (buffer == nullptr) {
+		int s;
+		buffer = new ProfileBuffer;
+		buffer->written.store(0);
+		buffer->merged.store(0);
+		for (s = 0; s < STAGE_COUNT; s++) {
+			buffer->stageTotal[s].store(0);
+			buffer->stageMerged[s] = 0;
+		}
+		buffer->owned.store(true);
+		buffers.push_back(buffer);
+	}
+	bufferOwner.buffer = buffer;
+	return buffer;
+}
+
+// move everything recorded since the last merge into frame, or throw it away when frame is null
+static void mergeBuffers(ProfileFrame* frame) {
+	int s;
+	std::lock_guard<std::mutex> guard(bufferLock);
+	for (ProfileBuffer* buffer : buffers) {
+		int64_t written = buffer->written.load(std::memory_order_acquire);
+		int64_t merged = buffer->merged.load(std::memory_order_relaxed);
+
+		for (s = 0; s < STAGE_COUNT; s++) {
+			int64_t total = buffer->stageTotal[s].load(std::memory_order_relaxed);
+			if (frame != nullptr) {
+				frame->stageTime[s] += total - buffer->stageMerged[s];
+			}
+			buffer->stageMerged[s] = total;
+		}
+		for (; merged < written; merged++) {
+			if (frame == nullptr || frame->numEvents >= profileEvents) {
+				merged = written;
+				break;
+			}
+			frame->events[frame->numEvents] = buffer->events[merged % profileRingEvents];
+			frame->numEvents++;
+		}
+		// hands the slots back to the recording thread
+		buffer->merged.store(merged, std::memory_order_release);
+	}
+}
+
+int64_t profileNow() {
+	// steady_clock is a vDSO read on linux and QueryPerformanceCounter on windows
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profileEpoch).count();
+}
+
+void profilerInit() {
+	std::lock_guard<std::mutex> guard(frameLock);
+	profileEpoch = std::chrono::steady_clock::now();
+	frameNumber = 0;
+	frameOpen = false;
+	mergeBuffers(nullptr);
+}
+
+void profilerBeginFrame() {
+	std::lock_guard<std::mutex> guard(frameLock);
+	int s;
+	ProfileFrame* frame = &frames[frameNumber % profileFrames];
+
+	frame->number = frameNumber;
+	frame->start = profileNow();
+	frame->end = frame->start;
+	for (s = 0; s < STAGE_COUNT; s++) {
+		frame->stageTime[s] = 0;
+	}
+	frame->numEvents = 0;
+	// events recorded while no frame was open are dropped
+	mergeBuffers(nullptr);
+
+	frameNumber++;
+	frameOpen = true;
+}
+
+void profilerEndFrame() {
+	std::lock_guard<std::mutex> guard(frameLock);
+	if (!frameOpen) {
+		return;
+	}
+	ProfileFrame* frame = &frames[(frameNumber - 1) % profileFrames];
+
+	mergeBuffers(frame);
+	frame->end = profileNow();
+	frame->stageTime[STAGE_FRAME] = frame->end - frame->start;
+	frameOpen = false;
+}
+
+void profileRecord(int stage, int64_t start, int64_t end) {
+	// job workers have buffers of their own, so time spent in jobs adds to its stage whichever thread runs it
+	ProfileBuffer* buffer = threadBuffer();
+
+	// only this thread writes the totals, so a plain load and store is enough
+	int64_t total = buffer->stageTotal[stage].load(std::memory_order_relaxed);
+	buffer->stageTotal[stage].store(total + end - start, std::memory_order_relaxed);
+
+	// a full ring only loses the event, its time is already in the total
+	int64_t written = buffer->written.load(std::memory_order_relaxed);
+	if (written - buffer->merged.load(std::memory_order_acquire) >= profileRingEvents) {
+		return;
+	}
+	ProfileEvent* event = &buffer->events[written % profileRingEvents];
+	event->stage = stage;
+	event->thread = profileThread;
+	event->start = start;
+	event->end = end;
+	buffer->written.store(written + 1, std::memory_order_release);
+}
+
+void profileSetThread(int thread) {
+	profileThread = thread;
+}
+
+int profilerFrameCount() {
+	std::lock_guard<std::mutex> guard(frameLock);
+	// the open frame is not complete yet
+	int64_t complete = frameOpen ? frameNumber - 1 : frameNumber;
+	return (complete < profileFrames) ? static_cast<int>(complete) : profileFrames - 1;
+}
+
+const ProfileFrame* profilerFrame(int age) {
+	std::lock_guard<std::mutex> guard(frameLock);
+	int64_t complete = frameOpen ? frameNumber - 1 : frameNumber;
+	return &frames[(complete - 1 - age) % profileFrames];
+}
+
+int64_t profilerAverage(int stage, int numFrames) {
+	int f;
+	int64_t total = 0;
+
+	if (numFrames > profilerFrameCount()) {
+		numFrames = profilerFrameCount();
+	}
+	if (numFrames == 0) {
+		return 0;
+	}
+	for (f = 0; f < numFrames; f++) {
+		total += profilerFrame(f)->stageTime[stage];
+	}
+	return total / numFrames;
+}
+
+const char* profileStageName(int stage) {
+	return stageNames[stage];
+}
+
+bool profilerExportTrace(const char* path) {
+	int f, e;
+	FILE* file = fopen(path, "w");
+	if (file == nullptr) {
+		return false;
+	}
+
+	// oldest frame first so the trace reads left to right
+	fprintf(file, "{\"traceEvents\":[\n");
+	bool first = true;
+	for (f = profilerFrameCount() - 1; f >= 0; f--) {
+		const ProfileFrame* frame = profilerFrame(f);
+
+		fprintf(file, "%s{\"name\":\"frame %lld\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":%.3f,\"dur\":%.3f}",
+			first ? "" : ",\n", static_cast<long long>(frame->number), frame->start / 1000.0, (frame->end - frame->start) / 1000.0);
+		first = false;
+
+		for (e = 0; e < frame->numEvents; e++) {
+			const ProfileEvent* event = &frame->events[e];
+			fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+				stageNames[event->stage], event->thread + 1, event->start / 1000.0, (event->end - event->start) / 1000.0);
+		}
+	}
+	fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+	fclose(file);
+	return true;
+}
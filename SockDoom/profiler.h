@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+// defines for profiler settings
+#define profileFrames      128                     // number of frames kept in the ring buffer
+#define profileEvents      256                     // timed events kept per frame
+#define profileRingEvents  1024                    // events a thread can hold until the frame ends
+
+// stages of a frame that get timed
+enum ProfileStage {
+	STAGE_FRAME,
+	STAGE_CLEAR,
+	STAGE_MOVE,
+	STAGE_SORT,
+	STAGE_TRANSFORM,
+	STAGE_RASTER,
+	STAGE_SWAP,
+	STAGE_COUNT
+};
+
+struct ProfileEvent {
+	// which stage this event belongs to
+	int stage;
+	// thread that recorded it, see profileSetThread()
+	int thread;
+	// start and end in nanoseconds since profilerInit()
+	int64_t start, end;
+};
+
+struct ProfileFrame {
+	// frame number, start and end in nanoseconds since profilerInit()
+	int64_t number, start, end;
+	// total time spent in each stage, summed over every thread including job workers
+	int64_t stageTime[STAGE_COUNT];
+	// individual events, extra events past profileEvents are only added to stageTime
+	ProfileEvent events[profileEvents];
+	int numEvents;
+};
+
+// current time in nanoseconds since profilerInit()
+int64_t profileNow();
+
+// restart the clock and the ring buffer, once at startup; the profiler is shared by every engine
+void profilerInit();
+// open a new frame in the ring buffer, overwriting the oldest one
+void profilerBeginFrame();
+// close the current frame and merge in what every thread recorded during it
+void profilerEndFrame();
+// add a timed event to the calling thread's buffer without locking, from any thread
+void profileRecord(int stage, int64_t start, int64_t end);
+// number the calling thread for the trace, 0 for the main thread
+void profileSetThread(int thread);
+
+// number of completed frames in the ring buffer
+int profilerFrameCount();
+// completed frame, 0 is the most recent
+const ProfileFrame* profilerFrame(int age);
+// average time of a stage in nanoseconds over the last numFrames completed frames
+int64_t profilerAverage(int stage, int numFrames);
+// name of a stage for reports
+const char* profileStageName(int stage);
+
+// write every frame in the ring buffer as chrome://tracing json
+bool profilerExportTrace(const char* path);
+
+// times the enclosing scope and records it as one event
+struct ProfileScope {
+	int stage;
+	int64_t start;
+
+	explicit ProfileScope(int s) : stage(s), start(profileNow()) {}
+	~ProfileScope() { profileRecord(stage, start, profileNow()); }
+};
+
+#define PROFILE_CONCAT2(a, b)   a##b
+#define PROFILE_CONCAT(a, b)    PROFILE_CONCAT2(a, b)
+#define PROFILE_SCOPE(stage)    ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(stage)
@@ -0,0 +1,794 @@
+#include "render.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "engine.h"
+#include "jobs.h"
+#include "profiler.h"
+
+// convert a palette color to rgb
+void paletteColor(int color, unsigned char rgb[3]) {
+	switch (color) {
+		case 0:  // yellow
+			rgb[0] = 255;
+			rgb[1] = 255;
+			rgb[2] = 0;
+			break;
+		case 1:  // dark yellow
+			rgb[0] = 160;
+			rgb[1] = 160;
+			rgb[2] = 0;
+			break;
+		case 2:  // green
+			rgb[0] = 0;
+			rgb[1] = 255;
+			rgb[2] = 0;
+			break;
+		case 3:  // dark green
+			rgb[0] = 0;
+			rgb[1] = 160;
+			rgb[2] = 0;
+			break;
+		case 4:  // cyan
+			rgb[0] = 0;
+			rgb[1] = 255;
+			rgb[2] = 255;
+			break;
+		case 5:  // dark cyan
+			rgb[0] = 0;
+			rgb[1] = 160;
+			rgb[2] = 160;
+			break;
+		case 6:  // brown
+			rgb[0] = 160;
+			rgb[1] = 100;
+			rgb[2] = 0;
+			break;
+		case 7:  // dark brown
+			rgb[0] = 110;
+			rgb[1] = 50;
+			rgb[2] = 0;
+			break;
+		case 8:  // background
+			rgb[0] = 0;
+			rgb[1] = 60;
+			rgb[2] = 130;
+			break;
+		case 9:  // white
+			rgb[0] = 255;
+			rgb[1] = 255;
+			rgb[2] = 255;
+			break;
+		case 10: // red
+			rgb[0] = 255;
+			rgb[1] = 0;
+			rgb[2] = 0;
+			break;
+		case 11: // magenta
+			rgb[0] = 255;
+			rgb[1] = 0;
+			rgb[2] = 255;
+			break;
+		case 12: // heatmap: never written
+			rgb[0] = 0;
+			rgb[1] = 0;
+			rgb[2] = 0;
+			break;
+		case 13: // heatmap: written once
+			rgb[0] = 0;
+			rgb[1] = 0;
+			rgb[2] = 110;
+			break;
+		case 14: // heatmap: written twice
+			rgb[0] = 0;
+			rgb[1] = 70;
+			rgb[2] = 255;
+			break;
+		case 15: // heatmap: written three times
+			rgb[0] = 0;
+			rgb[1] = 200;
+			rgb[2] = 200;
+			break;
+		case 16: // heatmap: written four times
+			rgb[0] = 0;
+			rgb[1] = 220;
+			rgb[2] = 0;
+			break;
+		case 17: // heatmap: written five times
+			rgb[0] = 230;
+			rgb[1] = 230;
+			rgb[2] = 0;
+			break;
+		case 18: // heatmap: written six times
+			rgb[0] = 255;
+			rgb[1] = 130;
+			rgb[2] = 0;
+			break;
+		case 19: // heatmap: written seven times
+			rgb[0] = 220;
+			rgb[1] = 0;
+			rgb[2] = 0;
+			break;
+		default:
+			rgb[0] = 255;
+			rgb[1] = 255;
+			rgb[2] = 255;
+			break;
+	}
+}
+
+void initView(View* view) {
+	view->renderMode = RENDER_NORMAL;
+	view->columnMode = COLUMNS_FULL;
+	view->columnStep = 1;
+	view->columnParity = 0;
+	view->heldValid = false;
+	view->frameBuffer = view->frameStorage;
+	view->depthBuffer = nullptr;
+	// per-frame scratch memory is allocated once here and reused every frame
+	if (view->frameArena.base == nullptr) {
+		arenaInit(&view->frameArena, frameArenaSize);
+	}
+}
+
+void freeView(View* view) {
+	arenaFree(&view->frameArena);
+}
+
+View* createView() {
+	// value initialized, so every array starts zeroed
+	View* view = new View();
+	initView(view);
+	return view;
+}
+
+void destroyView(View* view) {
+	if (view == nullptr) {
+		return;
+	}
+	freeView(view);
+	delete view;
+}
+
+// draw a pixel at x/y with a palette color
+void pixel(View* view, int x, int y, int color) {
+	// count the write instead of storing the color
+	if (view->renderMode == RENDER_OVERDRAW) {
+		view->overdraw[y * SW + x]++;
+		return;
+	}
+	view->frameBuffer[y * SW + x] = color;
+}
+
+// replace the frame with a heatmap of the writes counted in RENDER_OVERDRAW mode
+void resolveOverdraw(View* view) {
+	int i;
+	unsigned char* frameBuffer = view->frameBuffer;
+	unsigned short* overdraw = view->overdraw;
+
+	for (i = 0; i < SW * SH; i++) {
+		// eight or more writes stay white
+		frameBuffer[i] = (overdraw[i] < 8) ? 12 + overdraw[i] : 9;
+		overdraw[i] = 0;
+	}
+}
+
+// write the frame buffer as a binary ppm, top row first
+bool writeFramebufferPPM(const View* view, const char* path) {
+	return writePalettePPM(view->frameBuffer, SW, SH, path);
+}
+
+bool writePalettePPM(const unsigned char* pixels, int width, int height, const char* path) {
+	int x, y;
+	unsigned char palette[256][3];
+	FILE* file = fopen(path, "wb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	for (x = 0; x < 256; x++) {
+		paletteColor(x, palette[x]);
+	}
+	// a row at a time, upscaled frames have millions of pixels
+	std::vector<unsigned char> row(width * 3);
+	bool ok = fprintf(file, "P6\n%d %d\n255\n", width, height) > 0;
+	for (y = height - 1; y >= 0 && ok; y--) {
+		for (x = 0; x < width; x++) {
+			memcpy(&row[x * 3], palette[pixels[y * width + x]], 3);
+		}
+		ok = fwrite(row.data(), 1, row.size(), file) == row.size();
+	}
+
+	return fclose(file) == 0 && ok;
+}
+
+void clearBackground(View* view) {
+	int x, y;
+
+	if (statsEnabled) {
+		view->renderStats.clearPixels += SW * SH;
+	}
+	if (view->depthBuffer != nullptr) {
+		memset(view->depthBuffer, 0, SW * SH * sizeof(float));
+	}
+
+	for (y = 0; y < SH; y++) {
+		// clear background color
+		for (x = 0; x < SW; x++) { 
+			pixel(view, x, y, 8);
+		}
+	}
+}
+
+void cullBehindPlayer(int* x1, int* y1, int* z1, int x2, int y2, int z2) {
+	// distance plane to point a (first point)
+	float distA = *y1;
+	// distance plane to point b (second point)
+	float distB = y2;
+
+	float dist = distA - distB;
+	if (dist == 0) {
+		dist = 1;
+	}
+
+	// intersection factor (normalize between 0 and 1)
+	float norm = distA / (distA - distB);
+
+	*x1 = *x1 + norm * (x2 - (*x1));
+	*y1 = *y1 + norm * (y2 - (*y1));
+	// prevent divide by 0
+	if (*y1 == 0) {
+		*y1 = 1;
+	}
+	*z1 = *z1 + norm * (z2 - (*z1));
+}
+
+// distance to a floor or ceiling plane the given height above the camera, seen at screen row y
+static float planeDepth(const View* view, int plane, int y) {
+	float rows = y + 0.5f - view->horizon;
+	return (rows != 0) ? fabsf(plane * 200.0f / rows) : 0;
+}
+
+void drawWall(View* view, const Sector* sector, int x1, int x2, int b1, int b2, int t1, int t2, int d1, int d2, int color, int surfaceNum) {
+	int x, y;
+	SectorDraw* draw = &view->sectorDraw[surfaceNum];
+	RenderStats* renderStats = &view->renderStats;
+	float* depth = view->depthBuffer;
+	// 1 / distance changes linearly across the screen, ends behind the player were clipped to 1
+	float inverse1 = 1.0f / (d1 > 1 ? d1 : 1);
+	float inverse2 = 1.0f / (d2 > 1 ? d2 : 1);
+
+	// hold the difference in distnce between the bottom two points (b1 and b2)
+	// y distance of the bottom line
+	int distYBottom = b2 - b1;
+	// y distance of top line
+	int distYTop = t2 - t1;
+	// x distance
+	int distX = x2 - x1;
+
+	// hold initial value of x1 starting position
+	int xStart = x1;
+	// columns covered before culling
+	int width = (x2 > x1) ? x2 - x1 : 0;
+
+	// cull x
+	if (x1 < 1) {
+		x1 = 1;  // cull left
+	}
+	if (x2 < 1) {
+		x2 = 1;  // cull left
+	}
+	if (x1 > SW - 1) {
+		x1 = SW - 1;  // cull right
+	}
+	if (x2 > SW - 1) {
+		x2 = SW - 1;  // cull right
+	}
+	// skip to the first column of this frame's parity when only every other one is drawn
+	int step = view->columnStep;
+	if (step == 2 && (x1 & 1) != view->columnParity) {
+		x1++;
+	}
+
+	if (statsEnabled && draw->surface <= 0) {
+		int drawn = (x2 > x1) ? (x2 - x1 + step - 1) / step : 0;
+		renderStats->columns += drawn;
+		renderStats->columnsClamped += width - drawn;
+	}
+
+	// draw vertical lines between x1 and x2
+	for (x = x1; x < x2; x += step) {
+		// find y start and end point
+		// y bottom point
+		int y1 = distYBottom * (x - xStart + 0.5) / distX + b1;
+		int y2 = distYTop * (x - xStart + 0.5) / distX + t1;
+
+		// cull y
+		if (y1 < 1) {
+			y1 = 1;
+		}
+		if (y2 < 1) {
+			y2 = 1;
+		}
+		if (y1 > SH - 1) {
+			y1 = SH - 1;
+		}
+		if (y2 > SH - 1) {
+			y2 = SH - 1;
+		}
+
+		// draw surface
+		if (draw->surface == 1) {
+			// save bottom points
+			draw->surfaces[x] = y1;
+			continue;
+		}
+		if (draw->surface == 2) {
+			// save top points
+			draw->surfaces[x] = y2;
+			continue;
+		}
+		if (draw->surface == -1) {
+			// bottom
+			if (statsEnabled && y1 > draw->surfaces[x]) {
+				renderStats->surfacePixels += y1 - draw->surfaces[x];
+			}
+			for (y = draw->surfaces[x]; y < y1; y++) {
+				pixel(view, x, y, sector->colorBot);
+			}
+			if (depth != nullptr) {
+				for (y = draw->surfaces[x]; y < y1; y++) {
+					depth[y * SW + x] = planeDepth(view, draw->plane, y);
+				}
+			}
+		}
+		if (draw->surface == -2) {
+			// top
+			if (statsEnabled && draw->surfaces[x] > y1) {
+				renderStats->surfacePixels += draw->surfaces[x] - y1;
+			}
+			for (y = y1; y < draw->surfaces[x]; y++) {
+				pixel(view, x, y, sector->colorTop);
+			}
+			if (depth != nullptr) {
+				for (y = y1; y < draw->surfaces[x]; y++) {
+					depth[y * SW + x] = planeDepth(view, draw->plane, y);
+				}
+			}
+		}
+
+		// draw wall points
+		if (statsEnabled && y2 > y1) {
+			renderStats->wallPixels += y2 - y1;
+		}
+		for (y = y1; y < y2; y++) {
+			pixel(view, x, y, color);
+		}
+		if (depth != nullptr && y2 > y1) {
+			float wallDepth = 1.0f / (inverse1 + (inverse2 - inverse1) * (x - xStart + 0.5f) / distX);
+			for (y = y1; y < y2; y++) {
+				depth[y * SW + x] = wallDepth;
+			}
+		}
+	}
+}
+
+int distance(int x1, int y1, int x2, int y2) {
+	int distance = sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+	return distance;
+}
+
+void resetSectorOrder(View* view, int numSect) {
+	int s;
+
+	for (s = 0; s < numSect; s++) {
+		view->sectorOrder[s] = s;
+		view->sectorDraw[s].dist = 0;
+	}
+}
+
+// transform and draw the walls and surfaces of sector s, leaving its average distance in sectorDraw
+static void drawSector(View* view, const MapData* map, const Player* camera, float wallCos, float wallSin, int s) {
+	int w, i;
+	int wallX[4], wallY[4], wallZ[4];
+	const Wall* walls = map->walls;
+	const Sector* sectors = map->sectors;
+	SectorDraw* sectorDraw = view->sectorDraw;
+	RenderStats* renderStats = &view->renderStats;
+
+	//clear distance
+	sectorDraw[s].dist = 0;
+
+	// bottom surface
+	if (camera->z < sectors[s].z1) {
+		sectorDraw[s].surface = 1;
+		sectorDraw[s].plane = sectors[s].z1 - camera->z;
+	}
+	// top surface
+	else if (camera->z > sectors[s].z2) {
+		sectorDraw[s].surface = 2;
+		sectorDraw[s].plane = sectors[s].z1 + sectors[s].z2 - camera->z;
+	}
+	// no surface
+	else {
+		sectorDraw[s].surface = 0;
+	}
+
+	// loop to draw back faces of walls
+	for (i = 0; i < 2; i++) {
+		// projected walls of this pass, drawn once the whole sector is transformed
+		ProjectedWall* projected = arenaAllocArray<ProjectedWall>(&view->frameArena, sectors[s].wallEnd - sectors[s].wallStart);
+		int numProjected = 0;
+		int64_t transformStart = profileNow();
+
+		for (w = sectors[s].wallStart; w < sectors[s].wallEnd; w++) {
+			// offset the bottom 2 points by player position
+			int x1 = walls[w].x1 - camera->x;
+			int y1 = walls[w].y1 - camera->y;
+			int x2 = walls[w].x2 - camera->x;
+			int y2 = walls[w].y2 - camera->y;
+
+			// swap for surface
+			if (i == 0) {
+				int swap = x1;
+				x1 = x2;
+				x2 = swap;
+				swap = y1;
+				y1 = y2;
+				y2 = swap;
+			}
+
+			// rotate points around player for wall x position
+			wallX[0] = x1 * wallCos - y1 * wallSin;
+			wallX[1] = x2 * wallCos - y2 * wallSin;
+			// top line has same x
+			wallX[2] = wallX[0];
+			wallX[3] = wallX[1];
+
+			// rotate points around player for wall y position
+			wallY[0] = y1 * wallCos + x1 * wallSin;
+			wallY[1] = y2 * wallCos + x2 * wallSin;
+			// top line has same y
+			wallY[2] = wallY[0];
+			wallY[3] = wallY[1];
+
+			// store this wall's distance
+			sectorDraw[s].dist += distance(0, 0, (wallX[0] + wallX[1]) / 2, (wallY[0] + wallY[1]) / 2);
+
+			// rotate points around player for wall z position
+			wallZ[0] = sectors[s].z1 - camera->z + ((camera->look * wallY[0]) / 32.0);
+			wallZ[1] = sectors[s].z1 - camera->z + ((camera->look * wallY[1]) / 32.0);
+			// top line has higher z
+			wallZ[2] = wallZ[0] + sectors[s].z2;
+			wallZ[3] = wallZ[1] + sectors[s].z2;
+
+			if (statsEnabled) {
+				renderStats->wallsConsidered++;
+			}
+
+			// dont draw if behind player
+			if (wallY[0] < 1 && wallY[1] < 1) {
+				if (statsEnabled) {
+					renderStats->wallsCulled++;
+				}
+				continue;
+			}
+			if (statsEnabled && (wallY[0] < 1 || wallY[1] < 1)) {
+				renderStats->wallsClipped++;
+			}
+			// cull if one side is behind player
+			if (wallY[0] < 1) {
+				// bottom line
+				cullBehindPlayer(&wallX[0], &wallY[0], &wallZ[0], wallX[1], wallY[1], wallZ[1]);
+				// top line
+				cullBehindPlayer(&wallX[2], &wallY[2], &wallZ[2], wallX[3], wallY[3], wallZ[3]);
+			}
+			// cull if other side is behing player
+			if (wallY[1] < 1) {
+				// bottom line
+				cullBehindPlayer(&wallX[1], &wallY[1], &wallZ[1], wallX[0], wallY[0], wallZ[0]);
+				// top line
+				cullBehindPlayer(&wallX[3], &wallY[3], &wallZ[3], wallX[2], wallY[2], wallZ[2]);
+			}
+
+			// distance of both ends once clipped, for depth
+			int d1 = wallY[0];
+			int d2 = wallY[1];
+
+			// convert wall world position into screen position
+			wallX[0] = wallX[0] * 200 / wallY[0] + SW2;
+			wallY[0] = wallZ[0] * 200 / wallY[0] + SH2;
+			wallX[1] = wallX[1] * 200 / wallY[1] + SW2;
+			wallY[1] = wallZ[1] * 200 / wallY[1] + SH2;
+			wallX[2] = wallX[2] * 200 / wallY[2] + SW2;
+			wallY[2] = wallZ[2] * 200 / wallY[2] + SH2;
+			wallX[3] = wallX[3] * 200 / wallY[3] + SW2;
+			wallY[3] = wallZ[3] * 200 / wallY[3] + SH2;
+
+			// arena is full, draw the wall straight away
+			if (projected == nullptr) {
+				drawWall(view, &sectors[s], wallX[0], wallX[1], wallY[0], wallY[1], wallY[2], wallY[3], d1, d2, walls[w].color, s);
+				continue;
+			}
+
+			// save screen points
+			projected[numProjected].x1 = wallX[0];
+			projected[numProjected].x2 = wallX[1];
+			projected[numProjected].b1 = wallY[0];
+			projected[numProjected].b2 = wallY[1];
+			projected[numProjected].t1 = wallY[2];
+			projected[numProjected].t2 = wallY[3];
+			projected[numProjected].d1 = d1;
+			projected[numProjected].d2 = d2;
+			projected[numProjected].color = walls[w].color;
+			numProjected++;
+		}
+
+		int64_t rasterStart = profileNow();
+		profileRecord(STAGE_TRANSFORM, transformStart, rasterStart);
+
+		// draw points
+		for (w = 0; w < numProjected; w++) {
+			ProjectedWall* p = &projected[w];
+			drawWall(view, &sectors[s], p->x1, p->x2, p->b1, p->b2, p->t1, p->t2, p->d1, p->d2, p->color, s);
+		}
+		profileRecord(STAGE_RASTER, rasterStart, profileNow());
+
+		// find average sector distance
+		sectorDraw[s].dist /= (sectors[s].wallEnd - sectors[s].wallStart);
+		// flip surface number to negative to draw surface
+		sectorDraw[s].surface *= -1;
+	}
+}
+
+// pick the columns of a frame about to be drawn from the view's column mode
+static void beginColumns(View* view) {
+	if (view->columnMode == COLUMNS_LOW) {
+		view->columnStep = 2;
+		view->columnParity = 1;
+	}
+	else if (view->columnMode == COLUMNS_INTERLACED && view->renderMode == RENDER_NORMAL && view->heldValid) {
+		view->columnStep = 2;
+	}
+	else {
+		view->columnStep = 1;
+	}
+}
+
+// fill the columns the frame skipped: low detail copies each drawn column into the one right of it,
+// interlacing takes them from the last frame and keeps this one's for the next
+static void finishColumns(View* view) {
+	int x, y;
+	int parity = view->columnParity;
+	bool interlaced = view->columnMode == COLUMNS_INTERLACED && view->renderMode == RENDER_NORMAL;
+
+	if (interlaced && view->columnStep == 1) {
+		memcpy(view->heldFrame, view->frameBuffer, SW * SH);
+	}
+	else if (interlaced) {
+		for (y = 0; y < SH; y++) {
+			unsigned char* row = &view->frameBuffer[y * SW];
+			unsigned char* held = &view->heldFrame[y * SW];
+			for (x = 0; x < SW; x += 2) {
+				held[x + parity] = row[x + parity];
+				row[x + 1 - parity] = held[x + 1 - parity];
+			}
+		}
+	}
+	else if (view->columnStep == 2 && view->renderMode == RENDER_OVERDRAW) {
+		for (y = 0; y < SH; y++) {
+			unsigned short* overdraw = &view->overdraw[y * SW];
+			for (x = parity; x + 1 < SW; x += 2) {
+				overdraw[x + 1] = overdraw[x];
+			}
+		}
+	}
+	else if (view->columnStep == 2) {
+		for (y = 0; y < SH; y++) {
+			unsigned char* row = &view->frameBuffer[y * SW];
+			for (x = parity; x + 1 < SW; x += 2) {
+				row[x + 1] = row[x];
+			}
+		}
+	}
+	// depth has no last frame to take from, so it is copied in every mode
+	if (view->columnStep == 2 && view->depthBuffer != nullptr) {
+		for (y = 0; y < SH; y++) {
+			float* depth = &view->depthBuffer[y * SW];
+			for (x = parity; x + 1 < SW; x += 2) {
+				depth[x + 1] = depth[x];
+			}
+		}
+	}
+
+	view->heldValid = interlaced;
+	if (interlaced) {
+		view->columnParity = 1 - parity;
+	}
+}
+
+void draw3D(Engine* engine, const Player* camera) {
+	int s, w, n;
+	View* view = &engine->view;
+	float wallCos = engine->rot->cos[camera->angle];
+	float wallSin = engine->rot->sin[camera->angle];
+	int numSect = engine->map->numSect;
+	SectorDraw* sectorDraw = view->sectorDraw;
+	int* sectorOrder = view->sectorOrder;
+	view->horizon = SH2 + camera->look * 200 / 32.0f;
+
+	// order sectors by distance using bubble sort
+	int64_t sortStart = profileNow();
+	for (s = 0; s < numSect - 1; s++) {
+		for (w = 0; w < numSect - s - 1; w++) {
+			if (sectorDraw[sectorOrder[w]].dist < sectorDraw[sectorOrder[w + 1]].dist) {
+				int temp = sectorOrder[w];
+				sectorOrder[w] = sectorOrder[w + 1];
+				sectorOrder[w + 1] = temp;
+			}
+		}
+	}
+	profileRecord(STAGE_SORT, sortStart, profileNow());
+
+	// draw sectors
+	beginColumns(view);
+	for (n = 0; n < numSect; n++) {
+		drawSector(view, engine->map.get(), camera, wallCos, wallSin, sectorOrder[n]);
+	}
+	finishColumns(view);
+}
+
+void renderStill(Engine* engine) {
+	int i;
+	View* view = &engine->view;
+
+	// the sector order is sorted by the previous frame's distances, so draw a frame to settle it first
+	for (i = 0; i < 2; i++) {
+		if (view->renderMode == RENDER_OVERDRAW) {
+			memset(view->overdraw, 0, sizeof(view->overdraw));
+		}
+		resetRenderStats(&view->renderStats);
+		clearBackground(view);
+		// a still has no last frame for interlacing to keep columns from, so it is drawn whole
+		view->heldValid = false;
+		draw3D(engine, &engine->player);
+		arenaReset(&view->frameArena);
+	}
+	view->lastStats = view->renderStats;
+}
+
+// one call of drawViews, shared by the job threads
+struct ViewBatch {
+	const MapData* map;
+	const Rotation* rot;
+	const Player* cameras;
+	View* const* views;
+};
+
+// a sector to draw from one camera and the distance it is sorted by
+struct SectorKey {
+	int dist;
+	int sector;
+};
+
+// far to near, ties in map order like the stable bubble sort of draw3D
+static bool sectorFarther(const SectorKey& a, const SectorKey& b) {
+	return a.dist > b.dist || (a.dist == b.dist && a.sector < b.sector);
+}
+
+// the average distance draw3D leaves in sectorDraw after drawing sector s from the camera
+static int sectorDistance(const MapData* map, const Player* camera, float wallCos, float wallSin, int s) {
+	int w;
+	const Wall* walls = map->walls;
+	const Sector* sector = &map->sectors[s];
+	int numWalls = sector->wallEnd - sector->wallStart;
+	int sum = 0;
+
+	for (w = sector->wallStart; w < sector->wallEnd; w++) {
+		int x1 = walls[w].x1 - camera->x;
+		int y1 = walls[w].y1 - camera->y;
+		int x2 = walls[w].x2 - camera->x;
+		int y2 = walls[w].y2 - camera->y;
+		int wallX1 = x1 * wallCos - y1 * wallSin;
+		int wallX2 = x2 * wallCos - y2 * wallSin;
+		int wallY1 = y1 * wallCos + x1 * wallSin;
+		int wallY2 = y2 * wallCos + x2 * wallSin;
+		sum += distance(0, 0, (wallX1 + wallX2) / 2, (wallY1 + wallY2) / 2);
+	}
+	// draw3D sums the walls once per pass and divides after each pass
+	return (sum / numWalls + sum) / numWalls;
+}
+
+// false if no wall of sector s can reach a column of the screen, tested on its bounding circle.
+// only circles wholly in front of the near plane are tested against the sides, as clipped walls
+// can land anywhere; the margin covers the truncation of view space points to integers
+static bool sectorVisible(const MapData* map, const Player* camera, float wallCos, float wallSin, int s) {
+	const SectorMap* sectorMap = &map->sectorMap;
+	float x = sectorMap->centerX[s] - camera->x;
+	float y = sectorMap->centerY[s] - camera->y;
+	float viewX = x * wallCos - y * wallSin;
+	float viewY = y * wallCos + x * wallSin;
+	float radius = sectorMap->radius[s] + 2;
+
+	// every wall is behind the player
+	if (viewY + radius < 1) {
+		return false;
+	}
+	if (viewY - radius < 1) {
+		return true;
+	}
+	// every end projects at or left of column 1, or at or right of column SW - 1, so drawWall
+	// culls every column
+	float left = (200 * viewX + (SW2 - 1) * viewY) / sqrtf(200.0f * 200 + (SW2 - 1) * (SW2 - 1));
+	float right = (200 * viewX - (SW - 1 - SW2) * viewY) / sqrtf(200.0f * 200 + (SW - 1 - SW2) * (SW - 1 - SW2));
+	return left + radius >= 0 && right - radius <= 0;
+}
+
+// render one camera of a batch: clear, sort its visible sectors and draw them
+static void drawCamera(const MapData* map, const Rotation* rot, const Player* camera, View* view) {
+	int s, n;
+	float wallCos = rot->cos[camera->angle];
+	float wallSin = rot->sin[camera->angle];
+	view->horizon = SH2 + camera->look * 200 / 32.0f;
+
+	if (view->renderMode == RENDER_OVERDRAW) {
+		memset(view->overdraw, 0, sizeof(view->overdraw));
+	}
+	resetRenderStats(&view->renderStats);
+	clearBackground(view);
+
+	// before the visibility loop, which draws straight away when the arena is full
+	beginColumns(view);
+
+	// sort the sectors that can be seen by their distance this frame, the view's sector order is
+	// left alone for draw3D
+	int64_t sortStart = profileNow();
+	int numVisible = 0;
+	SectorKey* keys = arenaAllocArray<SectorKey>(&view->frameArena, map->numSect);
+	for (s = 0; s < map->numSect; s++) {
+		if (!sectorVisible(map, camera, wallCos, wallSin, s)) {
+			continue;
+		}
+		// arena is full, draw visible sectors straight away in map order
+		if (keys == nullptr) {
+			drawSector(view, map, camera, wallCos, wallSin, s);
+			continue;
+		}
+		keys[numVisible].dist = sectorDistance(map, camera, wallCos, wallSin, s);
+		keys[numVisible].sector = s;
+		numVisible++;
+	}
+	std::sort(keys, keys + numVisible, sectorFarther);
+	profileRecord(STAGE_SORT, sortStart, profileNow());
+
+	for (n = 0; n < numVisible; n++) {
+		drawSector(view, map, camera, wallCos, wallSin, keys[n].sector);
+	}
+	finishColumns(view);
+	arenaReset(&view->frameArena);
+	view->lastStats = view->renderStats;
+}
+
+static void drawViewRange(int begin, int end, void* data) {
+	const ViewBatch* batch = static_cast<const ViewBatch*>(data);
+	int i;
+
+	for (i = begin; i < end; i++) {
+		drawCamera(batch->map, batch->rot, &batch->cameras[i], batch->views[i]);
+	}
+}
+
+void drawViews(const Engine* world, const Player* cameras, View* const* views, int count) {
+	ViewBatch batch;
+
+	batch.map = world->map.get();
+	batch.rot = world->rot.get();
+	batch.cameras = cameras;
+	batch.views = views;
+	// one camera per job
+	parallelFor(count, 1, drawViewRange, &batch);
+}
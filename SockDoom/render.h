@@ -0,0 +1,116 @@
+#pragma once
+
+#include "arena.h"
+#include "stats.h"
+#include "types.h"
+
+// defines for renderer settings
+#define frameArenaSize     (256*1024)              // bytes of per-frame scratch memory
+
+// defines for render modes
+#define RENDER_NORMAL      0                       // write sector and wall colors
+#define RENDER_OVERDRAW    1                       // count writes per pixel and show them as a heatmap
+
+// defines for column modes, which trade horizontal detail for raster time
+#define COLUMNS_FULL       0                       // draw every column
+#define COLUMNS_LOW        1                       // draw odd columns and copy each into the even one right of it
+#define COLUMNS_INTERLACED 2                       // draw odd and even columns on alternate frames, keeping the others
+
+struct ProjectedWall {
+	// screen x of both ends
+	int x1, x2;
+	// screen y of both bottom points
+	int b1, b2;
+	// screen y of both top points
+	int t1, t2;
+	// view space distance of both ends
+	int d1, d2;
+	// wall color
+	int color;
+};
+
+// what the renderer keeps for each sector between frames
+struct SectorDraw {
+	// add y distances to sort drawing order
+	int dist;
+	// array to hold points for surface
+	int surfaces[SW];
+	// variable to determine which surface to draw (top, bottom, none)
+	int surface;
+	// height of that surface above the camera, for its depth
+	int plane;
+};
+
+// everything the renderer keeps for one camera: its frame, depth and the sector state carried
+// between frames. an engine has one for its player, drawViews() draws into one per camera
+struct View {
+	// per-frame scratch memory, allocated once by initView() and reused every frame
+	FrameArena frameArena;
+	RenderStats renderStats;
+	// statistics of the last completed frame, shown by the overlay
+	RenderStats lastStats;
+	// RENDER_NORMAL or RENDER_OVERDRAW
+	int renderMode;
+	// COLUMNS_FULL, COLUMNS_LOW or COLUMNS_INTERLACED; interlacing only applies to RENDER_NORMAL
+	int columnMode;
+	// the frame being drawn covers every columnStep-th column, those with x % 2 == columnParity when
+	// it is 2; interlaced mode flips the parity after each frame
+	int columnStep, columnParity;
+	// last whole frame of interlaced mode, the columns it skips come from here; heldValid is false
+	// until a frame was drawn in interlaced mode, and the first one draws every column
+	unsigned char heldFrame[SW * SH];
+	bool heldValid;
+	// palette color of every pixel, row 0 is the bottom of the screen; points at frameStorage
+	// unless the caller renders straight into its own SW * SH buffer
+	unsigned char* frameBuffer;
+	unsigned char frameStorage[SW * SH];
+	// view space distance of every pixel, row 0 is the bottom and 0 where only the background
+	// was drawn; the caller's SW * SH buffer, nullptr to skip depth
+	float* depthBuffer;
+	// screen row of the horizon this frame, for the depth of floors and ceilings
+	float horizon;
+	// writes per pixel this frame in RENDER_OVERDRAW mode
+	unsigned short overdraw[SW * SH];
+	// distances and surface points the renderer keeps for each sector of the map
+	SectorDraw sectorDraw[maxSect];
+	// sector numbers from far to near, sorted in place each frame so sector numbers stay stable
+	int sectorOrder[maxSect];
+};
+
+struct Engine;
+struct MapData;
+
+// set up a zeroed view: normal mode, drawing into its own frame storage, no depth
+void initView(View* view);
+// free the frame arena of a view
+void freeView(View* view);
+// allocate a view for drawViews(), a view alone is over a megabyte
+View* createView();
+void destroyView(View* view);
+
+// convert a palette color to rgb
+void paletteColor(int color, unsigned char rgb[3]);
+// draw a pixel at x/y with a palette color
+void pixel(View* view, int x, int y, int color);
+// replace the frame with a heatmap of the writes counted in RENDER_OVERDRAW mode
+void resolveOverdraw(View* view);
+// write the frame buffer as a binary ppm, top row first
+bool writeFramebufferPPM(const View* view, const char* path);
+// write palette colors of any size, row 0 at the bottom, as a binary ppm
+bool writePalettePPM(const unsigned char* pixels, int width, int height, const char* path);
+
+void clearBackground(View* view);
+void cullBehindPlayer(int* x1, int* y1, int* z1, int x2, int y2, int z2);
+void drawWall(View* view, const Sector* sector, int x1, int x2, int b1, int b2, int t1, int t2, int d1, int d2, int color, int surfaceNum);
+int distance(int x1, int y1, int x2, int y2);
+// put sectors back in map order, called when a map is loaded
+void resetSectorOrder(View* view, int numSect);
+// draw the map as seen from the camera, which can be a snapshot of the player
+void draw3D(Engine* engine, const Player* camera);
+// render the current player view into the frame buffer without a window
+void renderStill(Engine* engine);
+// render a full frame of the engine's map from each of count cameras into views[i], in parallel.
+// each view gets the image renderStill() gives from a fresh sector order: sectors are sorted
+// from its own camera every call rather than by the previous frame, and whole sectors outside
+// the view are skipped using the map's bounding circles
+void drawViews(const Engine* world, const Player* cameras, View* const* views, int count);
@@ -0,0 +1,220 @@
+#include "sectormap.h"
+
+#include <cmath>
+#include <iostream>
+
+#include "map.h"
+
+// cell along one axis, clamped to 0 to cells - 1; in 64 bits since map coordinates are not bounded
+static int sectorCellIndex(int coord, int origin, int size, int cells) {
+	long long cell = (static_cast<long long>(coord) - origin) / size;
+
+	if (cell < 0) {
+		return 0;
+	}
+	if (cell > cells - 1) {
+		return cells - 1;
+	}
+	return static_cast<int>(cell);
+}
+
+// cell range covered by a world space box, clamped to the grid
+static void sectorCellRange(const SectorMap* sectorMap, int minX, int minY, int maxX, int maxY, int* cx1, int* cy1, int* cx2, int* cy2) {
+	*cx1 = sectorCellIndex(minX, sectorMap->originX, sectorMap->size, sectorMap->width);
+	*cy1 = sectorCellIndex(minY, sectorMap->originY, sectorMap->size, sectorMap->height);
+	*cx2 = sectorCellIndex(maxX, sectorMap->originX, sectorMap->size, sectorMap->width);
+	*cy2 = sectorCellIndex(maxY, sectorMap->originY, sectorMap->size, sectorMap->height);
+}
+
+// true if the bounding boxes of two sectors overlap or touch
+static bool boundsTouch(const SectorMap* sectorMap, int a, int b) {
+	return sectorMap->minX[a] <= sectorMap->maxX[b] && sectorMap->minX[b] <= sectorMap->maxX[a] &&
+		sectorMap->minY[a] <= sectorMap->maxY[b] && sectorMap->minY[b] <= sectorMap->maxY[a];
+}
+
+bool buildSectorMap(MapData* map) {
+	int s, w, c, cx, cy, l;
+	SectorMap* sectorMap = &map->sectorMap;
+	const Blockmap* blockmap = &map->blockmap;
+	const Wall* walls = map->walls;
+	const Sector* sectors = map->sectors;
+	int numSect = map->numSect;
+
+	// bounding box of each sector
+	for (s = 0; s < numSect; s++) {
+		for (w = sectors[s].wallStart; w < sectors[s].wallEnd; w++) {
+			int x1 = (walls[w].x1 < walls[w].x2) ? walls[w].x1 : walls[w].x2;
+			int x2 = (walls[w].x1 < walls[w].x2) ? walls[w].x2 : walls[w].x1;
+			int y1 = (walls[w].y1 < walls[w].y2) ? walls[w].y1 : walls[w].y2;
+			int y2 = (walls[w].y1 < walls[w].y2) ? walls[w].y2 : walls[w].y1;
+			if (w == sectors[s].wallStart || x1 < sectorMap->minX[s]) {
+				sectorMap->minX[s] = x1;
+			}
+			if (w == sectors[s].wallStart || y1 < sectorMap->minY[s]) {
+				sectorMap->minY[s] = y1;
+			}
+			if (w == sectors[s].wallStart || x2 > sectorMap->maxX[s]) {
+				sectorMap->maxX[s] = x2;
+			}
+			if (w == sectors[s].wallStart || y2 > sectorMap->maxY[s]) {
+				sectorMap->maxY[s] = y2;
+			}
+		}
+		long long halfX = (static_cast<long long>(sectorMap->maxX[s]) - sectorMap->minX[s] + 1) / 2;
+		long long halfY = (static_cast<long long>(sectorMap->maxY[s]) - sectorMap->minY[s] + 1) / 2;
+		sectorMap->centerX[s] = static_cast<int>(sectorMap->minX[s] + halfX);
+		sectorMap->centerY[s] = static_cast<int>(sectorMap->minY[s] + halfY);
+		sectorMap->radius[s] = static_cast<int>(ceil(sqrt(static_cast<double>(halfX) * halfX + static_cast<double>(halfY) * halfY)));
+	}
+
+	// same cells as the blockmap
+	sectorMap->originX = blockmap->originX;
+	sectorMap->originY = blockmap->originY;
+	sectorMap->size = blockmap->size;
+	sectorMap->width = blockmap->width;
+	sectorMap->height = blockmap->height;
+	int numCells = sectorMap->width * sectorMap->height;
+
+	// count the sectors of each cell, then turn the counts into offsets
+	for (c = 0; c <= numCells; c++) {
+		sectorMap->start[c] = 0;
+	}
+	for (s = 0; s < numSect; s++) {
+		int cx1, cy1, cx2, cy2;
+		sectorCellRange(sectorMap, sectorMap->minX[s], sectorMap->minY[s], sectorMap->maxX[s], sectorMap->maxY[s], &cx1, &cy1, &cx2, &cy2);
+		for (cy = cy1; cy <= cy2; cy++) {
+			for (cx = cx1; cx <= cx2; cx++) {
+				sectorMap->start[cy * sectorMap->width + cx + 1]++;
+			}
+		}
+	}
+	for (c = 0; c < numCells; c++) {
+		sectorMap->start[c + 1] += sectorMap->start[c];
+	}
+	if (sectorMap->start[numCells] > maxSectorLinks) {
+		std::cout << "Sector grid needs " << sectorMap->start[numCells] << " sector links, the limit is " << maxSectorLinks << std::endl;
+		sectorMap->width = 0;
+		sectorMap->height = 0;
+		return false;
+	}
+
+	// fill each cell, using its start as a cursor and shifting back afterwards
+	for (s = 0; s < numSect; s++) {
+		int cx1, cy1, cx2, cy2;
+		sectorCellRange(sectorMap, sectorMap->minX[s], sectorMap->minY[s], sectorMap->maxX[s], sectorMap->maxY[s], &cx1, &cy1, &cx2, &cy2);
+		for (cy = cy1; cy <= cy2; cy++) {
+			for (cx = cx1; cx <= cx2; cx++) {
+				sectorMap->links[sectorMap->start[cy * sectorMap->width + cx]++] = s;
+			}
+		}
+	}
+	for (c = numCells; c > 0; c--) {
+		sectorMap->start[c] = sectorMap->start[c - 1];
+	}
+	sectorMap->start[0] = 0;
+
+	// neighbors are sectors whose bounding boxes touch, found through the cells each sector covers
+	int numNeighbors = 0;
+	for (s = 0; s < numSect; s++) {
+		int cx1, cy1, cx2, cy2;
+		sectorMap->neighborStart[s] = numNeighbors;
+		sectorCellRange(sectorMap, sectorMap->minX[s], sectorMap->minY[s], sectorMap->maxX[s], sectorMap->maxY[s], &cx1, &cy1, &cx2, &cy2);
+		for (cy = cy1; cy <= cy2; cy++) {
+			for (cx = cx1; cx <= cx2; cx++) {
+				int cell = cy * sectorMap->width + cx;
+				for (l = sectorMap->start[cell]; l < sectorMap->start[cell + 1]; l++) {
+					int other = sectorMap->links[l];
+					if (other == s || !boundsTouch(sectorMap, s, other)) {
+						continue;
+					}
+
+					// skip sectors already listed from another cell
+					bool listed = false;
+					for (int n = sectorMap->neighborStart[s]; n < numNeighbors && !listed; n++) {
+						listed = sectorMap->neighbors[n] == other;
+					}
+					if (listed) {
+						continue;
+					}
+					if (numNeighbors == maxNeighborLinks) {
+						std::cout << "Sector neighbors exceed the limit of " << maxNeighborLinks << std::endl;
+						sectorMap->width = 0;
+						sectorMap->height = 0;
+						return false;
+					}
+					sectorMap->neighbors[numNeighbors++] = other;
+				}
+			}
+		}
+	}
+	sectorMap->neighborStart[numSect] = numNeighbors;
+	return true;
+}
+
+bool pointInSector(const MapData* map, int s, int x, int y) {
+	int w;
+	bool inside = false;
+	const SectorMap* sectorMap = &map->sectorMap;
+	const Wall* walls = map->walls;
+	const Sector* sectors = map->sectors;
+
+	if (x < sectorMap->minX[s] || x > sectorMap->maxX[s] || y < sectorMap->minY[s] || y > sectorMap->maxY[s]) {
+		return false;
+	}
+
+	// count wall crossings of a ray from x/y towards +x
+	for (w = sectors[s].wallStart; w < sectors[s].wallEnd; w++) {
+		int x1 = walls[w].x1, y1 = walls[w].y1;
+		int x2 = walls[w].x2, y2 = walls[w].y2;
+		if ((y1 > y) != (y2 > y)) {
+			// x of the crossing, compared without dividing
+			long long lhs = (static_cast<long long>(x) - x1) * (static_cast<long long>(y2) - y1);
+			long long rhs = (static_cast<long long>(x2) - x1) * (static_cast<long long>(y) - y1);
+			if ((y2 > y1) ? lhs < rhs : lhs > rhs) {
+				inside = !inside;
+			}
+		}
+	}
+	return inside;
+}
+
+int findSector(const MapData* map, int x, int y) {
+	int l;
+	const SectorMap* sectorMap = &map->sectorMap;
+
+	if (sectorMap->width == 0 || x < sectorMap->originX || y < sectorMap->originY) {
+		return -1;
+	}
+	long long cx = (static_cast<long long>(x) - sectorMap->originX) / sectorMap->size;
+	long long cy = (static_cast<long long>(y) - sectorMap->originY) / sectorMap->size;
+	if (cx >= sectorMap->width || cy >= sectorMap->height) {
+		return -1;
+	}
+
+	int cell = static_cast<int>(cy) * sectorMap->width + static_cast<int>(cx);
+	for (l = sectorMap->start[cell]; l < sectorMap->start[cell + 1]; l++) {
+		if (pointInSector(map, sectorMap->links[l], x, y)) {
+			return sectorMap->links[l];
+		}
+	}
+	return -1;
+}
+
+int updateSector(const MapData* map, int lastSector, int x, int y) {
+	int n;
+	const SectorMap* sectorMap = &map->sectorMap;
+
+	if (lastSector >= 0 && lastSector < map->numSect) {
+		// most moves stay in the same sector
+		if (pointInSector(map, lastSector, x, y)) {
+			return lastSector;
+		}
+		// then the sectors next to it
+		for (n = sectorMap->neighborStart[lastSector]; n < sectorMap->neighborStart[lastSector + 1]; n++) {
+			if (pointInSector(map, sectorMap->neighbors[n], x, y)) {
+				return sectorMap->neighbors[n];
+			}
+		}
+	}
+	return findSector(map, x, y);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "blockmap.h"
+#include "types.h"
+
+// defines for sector lookup settings
+#define maxSectorLinks     16384                   // most sector references over all grid cells
+#define maxNeighborLinks   16384                   // most neighbor references over all sectors
+
+// uniform grid over the map, each cell lists the sectors whose bounding box touches it,
+// plus each sector's neighbors for the incremental lookup of moving actors
+struct SectorMap {
+	// world position of the bottom left corner of cell 0
+	int originX, originY;
+	// cell size in world units
+	int size;
+	// number of cells across and up
+	int width, height;
+	// sectors of cell c are links[start[c]] to links[start[c + 1] - 1]
+	int start[maxBlocks + 1];
+	int links[maxSectorLinks];
+	// bounding box of each sector
+	int minX[maxSect], minY[maxSect], maxX[maxSect], maxY[maxSect];
+	// circle around each bounding box, for culling whole sectors from a camera
+	int centerX[maxSect], centerY[maxSect], radius[maxSect];
+	// neighbors of sector s are neighbors[neighborStart[s]] to neighbors[neighborStart[s + 1] - 1]
+	int neighborStart[maxSect + 1];
+	int neighbors[maxNeighborLinks];
+};
+
+// build the sector grid and neighbor lists of a map after its blockmap, called when the map is built
+bool buildSectorMap(MapData* map);
+// true if x/y is inside the walls of sector s
+bool pointInSector(const MapData* map, int s, int x, int y);
+// sector containing x/y using the grid, -1 if it is outside every sector
+int findSector(const MapData* map, int x, int y);
+// sector containing x/y for something last seen in lastSector: tries that sector and its
+// neighbors before falling back to the grid
+int updateSector(const MapData* map, int lastSector, int x, int y);
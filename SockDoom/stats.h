@@ -0,0 +1,48 @@
+#pragma once
+
+// render statistics are on by default and compiled out of release builds,
+// define SOCKDOOM_STATS=1 to keep them in an optimized build
+#ifndef SOCKDOOM_STATS
+#ifdef NDEBUG
+#define SOCKDOOM_STATS 0
+#else
+#define SOCKDOOM_STATS 1
+#endif
+#endif
+
+// every counter update is guarded by this so disabled builds emit no code for them
+constexpr bool statsEnabled = SOCKDOOM_STATS != 0;
+
+// work done by one frame, reset at the start of every frame
+struct RenderStats {
+	// walls transformed by draw3D, one per wall per pass
+	int wallsConsidered;
+	// walls skipped because both ends are behind the player
+	int wallsCulled;
+	// walls with one end clipped to the player plane
+	int wallsClipped;
+	// columns rasterized by drawWall
+	int columns;
+	// columns removed by the left and right screen edges
+	int columnsClamped;
+	// pixels written by clearBackground
+	int clearPixels;
+	// pixels written for walls
+	int wallPixels;
+	// pixels written for floors and ceilings
+	int surfacePixels;
+};
+
+inline void resetRenderStats(RenderStats* stats) {
+	*stats = RenderStats();
+}
+
+// every pixel written this frame
+inline int statsPixelsWritten(const RenderStats* stats) {
+	return stats->clearPixels + stats->wallPixels + stats->surfacePixels;
+}
+
+// pixels written per screen pixel, times 100
+inline int statsOverdraw(const RenderStats* stats, int screenPixels) {
+	return static_cast<int>(static_cast<long long>(statsPixelsWritten(stats)) * 100 / screenPixels);
+}
@@ -0,0 +1,511 @@
+#include "stream.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#define sendFlags          0
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#define sendFlags          MSG_NOSIGNAL            // a viewer that went away is an error, not a signal
+#endif
+
+#define noSocket           (-1)
+
+// the largest run a pair of run length and color can hold
+#define maxRun             255
+
+#ifdef _WIN32
+
+static bool socketsInit() {
+	static bool started = false;
+	WSADATA data;
+	if (!started) {
+		started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+	}
+	return started;
+}
+
+static void closeSocket(intptr_t s) {
+	closesocket(static_cast<SOCKET>(s));
+}
+
+static bool setNonBlocking(intptr_t s) {
+	u_long on = 1;
+	return ioctlsocket(static_cast<SOCKET>(s), FIONBIO, &on) == 0;
+}
+
+static bool wouldBlock() {
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+#else
+
+static bool socketsInit() {
+	return true;
+}
+
+static void closeSocket(intptr_t s) {
+	close(static_cast<int>(s));
+}
+
+static bool setNonBlocking(intptr_t s) {
+	int flags = fcntl(static_cast<int>(s), F_GETFL, 0);
+	return flags >= 0 && fcntl(static_cast<int>(s), F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static bool wouldBlock() {
+	return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+#endif
+
+static void put16(unsigned char* p, int value) {
+	p[0] = value & 255;
+	p[1] = (value >> 8) & 255;
+}
+
+static void put32(unsigned char* p, uint32_t value) {
+	p[0] = value & 255;
+	p[1] = (value >> 8) & 255;
+	p[2] = (value >> 16) & 255;
+	p[3] = (value >> 24) & 255;
+}
+
+static int get16(const unsigned char* p) {
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t get32(const unsigned char* p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+// first pixel of tile t in the frame
+static int tileOffset(int t) {
+	return (t / streamTilesX) * streamTile * SW + (t % streamTilesX) * streamTile;
+}
+
+static bool tileChanged(const unsigned char* previous, const unsigned char* frame, int t) {
+	int y;
+	int offset = tileOffset(t);
+
+	for (y = 0; y < streamTile; y++) {
+		if (memcmp(&previous[offset + y * SW], &frame[offset + y * SW], streamTile) != 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// run length encode tile t into out, returns its length or -1 once it is no shorter than the raw tile
+static int encodeRuns(const unsigned char* frame, int t, unsigned char* out) {
+	int x, y;
+	int offset = tileOffset(t);
+	int length = 0;
+	int run = 0;
+	int color = frame[offset];
+
+	for (y = 0; y < streamTile; y++) {
+		for (x = 0; x < streamTile; x++) {
+			int c = frame[offset + y * SW + x];
+			if (c == color && run < maxRun) {
+				run++;
+				continue;
+			}
+			if (length + 2 >= streamTile * streamTile) {
+				return -1;
+			}
+			out[length++] = run;
+			out[length++] = color;
+			color = c;
+			run = 1;
+		}
+	}
+	if (length + 2 >= streamTile * streamTile) {
+		return -1;
+	}
+	out[length++] = run;
+	out[length++] = color;
+	return length;
+}
+
+int streamEncode(const unsigned char* previous, const unsigned char* frame, uint32_t number, bool key, unsigned char* message) {
+	int t, y;
+	int numTiles = 0;
+	int size = streamHeaderSize;
+
+	for (t = 0; t < streamTiles; t++) {
+		if (!key && !tileChanged(previous, frame, t)) {
+			continue;
+		}
+		unsigned char* tile = &message[size];
+		int length = encodeRuns(frame, t, tile + 4);
+		if (length >= 0) {
+			put16(tile, t | TILE_RLE);
+		}
+		else {
+			// noisy tiles go raw
+			int offset = tileOffset(t);
+			length = streamTile * streamTile;
+			for (y = 0; y < streamTile; y++) {
+				memcpy(tile + 4 + y * streamTile, &frame[offset + y * SW], streamTile);
+			}
+			put16(tile, t);
+		}
+		put16(tile + 2, length);
+		size += 4 + length;
+		numTiles++;
+	}
+
+	put32(message, streamMagic);
+	put32(message + 4, number);
+	put16(message + 8, numTiles);
+	message[10] = key ? STREAM_KEY : 0;
+	message[11] = 0;
+	put32(message + 12, size - streamHeaderSize);
+	return size;
+}
+
+bool streamDecode(const unsigned char* message, int size, unsigned char* frame, uint32_t* number) {
+	int i, x, y;
+
+	if (size < streamHeaderSize || get32(message) != streamMagic || get32(message + 12) != static_cast<uint32_t>(size - streamHeaderSize)) {
+		return false;
+	}
+	int numTiles = get16(message + 8);
+	int pos = streamHeaderSize;
+
+	for (i = 0; i < numTiles; i++) {
+		if (pos + 4 > size) {
+			return false;
+		}
+		int index = get16(&message[pos]);
+		int length = get16(&message[pos + 2]);
+		int t = index & ~TILE_RLE;
+		const unsigned char* data = &message[pos + 4];
+		pos += 4 + length;
+		if (t >= streamTiles || pos > size) {
+			return false;
+		}
+		int offset = tileOffset(t);
+
+		if ((index & TILE_RLE) == 0) {
+			if (length != streamTile * streamTile) {
+				return false;
+			}
+			for (y = 0; y < streamTile; y++) {
+				memcpy(&frame[offset + y * SW], data + y * streamTile, streamTile);
+			}
+			continue;
+		}
+
+		// runs must fill the tile exactly
+		int filled = 0;
+		int run = 0;
+		for (x = 0; x + 1 < length; x += 2) {
+			run = data[x];
+			if (filled + run > streamTile * streamTile) {
+				return false;
+			}
+			for (; run > 0; run--, filled++) {
+				frame[offset + (filled / streamTile) * SW + filled % streamTile] = data[x + 1];
+			}
+		}
+		if (filled != streamTile * streamTile || (length & 1) != 0) {
+			return false;
+		}
+	}
+	*number = get32(message + 4);
+	return pos == size;
+}
+
+bool streamServerStart(StreamServer* server, int port) {
+	int i;
+	struct sockaddr_in address;
+	int on = 1;
+
+	server->running = false;
+	server->listener = noSocket;
+	for (i = 0; i < maxStreamClients; i++) {
+		server->clients[i].socket = noSocket;
+	}
+	if (!socketsInit()) {
+		std::cout << "Failed to start sockets" << std::endl;
+		return false;
+	}
+
+	intptr_t listener = socket(AF_INET, SOCK_STREAM, 0);
+	if (listener == noSocket) {
+		std::cout << "Failed to create a socket for the frame server" << std::endl;
+		return false;
+	}
+	setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&on), sizeof(on));
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_ANY);
+	address.sin_port = htons(static_cast<unsigned short>(port));
+	if (bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, maxStreamClients) != 0 ||
+		!setNonBlocking(listener)) {
+		std::cout << "Failed to listen for viewers on port " << port << std::endl;
+		closeSocket(listener);
+		return false;
+	}
+	socklen_t length = sizeof(address);
+	getsockname(listener, reinterpret_cast<struct sockaddr*>(&address), &length);
+
+	server->listener = listener;
+	server->port = ntohs(address.sin_port);
+	server->frames = 0;
+	server->bytesSent = 0;
+	memset(server->previous, 0, sizeof(server->previous));
+	server->delta.resize(streamMaxMessage);
+	server->key.resize(streamMaxMessage);
+	server->running = true;
+	return true;
+}
+
+// take every viewer waiting to connect
+static void acceptClients(StreamServer* server) {
+	int i;
+	int on = 1;
+
+	for (;;) {
+		intptr_t s = accept(server->listener, nullptr, nullptr);
+		if (s == noSocket) {
+			return;
+		}
+		for (i = 0; i < maxStreamClients && server->clients[i].socket != noSocket; i++) {
+		}
+		if (i == maxStreamClients || !setNonBlocking(s)) {
+			std::cout << "Frame server is full, turning a viewer away" << std::endl;
+			closeSocket(s);
+			continue;
+		}
+		// frames are small and sent one at a time, so do not hold them back
+		setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+		server->clients[i].socket = s;
+		server->clients[i].pending.clear();
+		server->clients[i].needsKey = true;
+	}
+}
+
+static void dropClient(StreamClient* client) {
+	closeSocket(client->socket);
+	client->socket = noSocket;
+	client->pending.clear();
+}
+
+// send as much of data as the socket takes now and keep the rest pending, false if the viewer is gone
+static bool sendSome(StreamServer* server, StreamClient* client, const unsigned char* data, int size) {
+	int sent = 0;
+
+	while (sent < size) {
+		int n = send(client->socket, reinterpret_cast<const char*>(data + sent), size - sent, sendFlags);
+		if (n < 0 && wouldBlock()) {
+			break;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		sent += n;
+	}
+	server->bytesSent += sent;
+	client->pending.assign(data + sent, data + size);
+	return true;
+}
+
+void streamPublish(StreamServer* server, const unsigned char* frame) {
+	int i;
+	int deltaSize = -1, keySize = -1;
+
+	if (!server->running) {
+		return;
+	}
+	acceptClients(server);
+	uint32_t number = server->frames + 1;
+
+	for (i = 0; i < maxStreamClients; i++) {
+		StreamClient* client = &server->clients[i];
+		if (client->socket == noSocket) {
+			continue;
+		}
+		// finish the last message first; a viewer still behind skips this frame
+		if (!client->pending.empty()) {
+			std::vector<unsigned char> rest;
+			rest.swap(client->pending);
+			if (!sendSome(server, client, rest.data(), static_cast<int>(rest.size()))) {
+				dropClient(client);
+				continue;
+			}
+			if (!client->pending.empty()) {
+				client->needsKey = true;
+				continue;
+			}
+		}
+
+		// each message is encoded once however many viewers get it
+		const unsigned char* message;
+		int size;
+		if (client->needsKey) {
+			if (keySize < 0) {
+				keySize = streamEncode(server->previous, frame, number, true, server->key.data());
+			}
+			message = server->key.data();
+			size = keySize;
+		}
+		else {
+			if (deltaSize < 0) {
+				deltaSize = streamEncode(server->previous, frame, number, false, server->delta.data());
+			}
+			message = server->delta.data();
+			size = deltaSize;
+		}
+		if (!sendSome(server, client, message, size)) {
+			dropClient(client);
+			continue;
+		}
+		client->needsKey = false;
+	}
+
+	memcpy(server->previous, frame, SW * SH);
+	server->frames = number;
+}
+
+bool streamServerWait(StreamServer* server, int timeout) {
+	fd_set readable;
+	struct timeval wait;
+
+	if (!server->running) {
+		return false;
+	}
+	acceptClients(server);
+	if (streamClients(server) > 0) {
+		return true;
+	}
+	FD_ZERO(&readable);
+	FD_SET(server->listener, &readable);
+	wait.tv_sec = timeout / 1000;
+	wait.tv_usec = (timeout % 1000) * 1000;
+	select(static_cast<int>(server->listener + 1), &readable, nullptr, nullptr, &wait);
+	acceptClients(server);
+	return streamClients(server) > 0;
+}
+
+int streamClients(const StreamServer* server) {
+	int i, count = 0;
+
+	for (i = 0; i < maxStreamClients && server->running; i++) {
+		count += server->clients[i].socket != noSocket;
+	}
+	return count;
+}
+
+void streamServerStop(StreamServer* server) {
+	int i;
+
+	if (!server->running) {
+		return;
+	}
+	for (i = 0; i < maxStreamClients; i++) {
+		if (server->clients[i].socket != noSocket) {
+			dropClient(&server->clients[i]);
+		}
+	}
+	closeSocket(server->listener);
+	server->listener = noSocket;
+	server->running = false;
+}
+
+bool streamConnect(StreamReader* reader, const char* host, int port) {
+	struct addrinfo hints;
+	struct addrinfo* found = nullptr;
+	char service[16];
+	int on = 1;
+
+	reader->socket = noSocket;
+	reader->number = 0;
+	reader->bytesReceived = 0;
+	memset(reader->frame, 0, sizeof(reader->frame));
+	reader->message.resize(streamMaxMessage);
+	if (!socketsInit()) {
+		std::cout << "Failed to start sockets" << std::endl;
+		return false;
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_STREAM;
+	snprintf(service, sizeof(service), "%d", port);
+	if (getaddrinfo(host, service, &hints, &found) != 0) {
+		std::cout << "Failed to look up " << host << std::endl;
+		return false;
+	}
+	intptr_t s = socket(found->ai_family, found->ai_socktype, found->ai_protocol);
+	if (s == noSocket || connect(s, found->ai_addr, static_cast<int>(found->ai_addrlen)) != 0) {
+		std::cout << "Failed to connect to " << host << " port " << port << std::endl;
+		if (s != noSocket) {
+			closeSocket(s);
+		}
+		freeaddrinfo(found);
+		return false;
+	}
+	freeaddrinfo(found);
+	setsockopt(s, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&on), sizeof(on));
+	reader->socket = s;
+	return true;
+}
+
+// read exactly size bytes, false if the connection closed first
+static bool receiveAll(StreamReader* reader, unsigned char* data, int size) {
+	int got = 0;
+
+	while (got < size) {
+		int n = recv(reader->socket, reinterpret_cast<char*>(data + got), size - got, 0);
+		if (n <= 0) {
+			return false;
+		}
+		got += n;
+	}
+	reader->bytesReceived += size;
+	return true;
+}
+
+bool streamReceive(StreamReader* reader) {
+	unsigned char* message = reader->message.data();
+
+	if (reader->socket == noSocket || !receiveAll(reader, message, streamHeaderSize)) {
+		return false;
+	}
+	uint32_t payload = get32(message + 12);
+	if (get32(message) != streamMagic || payload > streamMaxMessage - streamHeaderSize) {
+		std::cout << "Frame stream is corrupt" << std::endl;
+		return false;
+	}
+	if (!receiveAll(reader, message + streamHeaderSize, static_cast<int>(payload))) {
+		return false;
+	}
+	if (!streamDecode(message, streamHeaderSize + static_cast<int>(payload), reader->frame, &reader->number)) {
+		std::cout << "Frame stream is corrupt" << std::endl;
+		return false;
+	}
+	return true;
+}
+
+void streamDisconnect(StreamReader* reader) {
+	if (reader->socket != noSocket) {
+		closeSocket(reader->socket);
+		reader->socket = noSocket;
+	}
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "types.h"
+
+// defines for frame streaming settings
+#define streamMagic        0x54534453u             // "SDST" at the start of every frame message
+#define streamTile         10                      // tile width and height in pixels, SW and SH are multiples
+#define streamTilesX       (SW / streamTile)
+#define streamTilesY       (SH / streamTile)
+#define streamTiles        (streamTilesX * streamTilesY)
+#define streamHeaderSize   16                      // bytes of a frame message before its tiles
+#define streamMaxMessage   (streamHeaderSize + streamTiles * (4 + streamTile * streamTile))
+#define maxStreamClients   8                       // viewers one server sends to
+
+// a frame message is little endian: magic, frame number (4 bytes each), number of tiles (2),
+// flags (1, STREAM_KEY for a whole frame), 1 unused and the bytes of tiles that follow (4).
+// each tile is its index with TILE_RLE set in the top bit when it is run length encoded (2), its
+// length (2) and then the tile's palette colors row by row from the bottom, raw or as pairs of
+// run length and color
+#define STREAM_KEY         1                       // message holds every tile, not only the changed ones
+#define TILE_RLE           0x8000                  // tile data is run length encoded
+
+// one viewer of a server
+struct StreamClient {
+	// socket, -1 when the slot is free
+	intptr_t socket;
+	// bytes of the last message the socket did not take yet
+	std::vector<unsigned char> pending;
+	// the viewer missed a frame, so the next one it gets must be whole
+	bool needsKey;
+};
+
+// listens on a port and sends every published frame to each connected viewer as the tiles
+// that changed. sockets never block, so publishing costs the caller only the encoding; a viewer
+// that falls behind skips frames and gets a whole one once it catches up
+struct StreamServer {
+	// false until streamServerStart() succeeds, so a zeroed server publishes nothing
+	bool running;
+	intptr_t listener;
+	// port being listened on, useful when 0 was asked for
+	int port;
+	StreamClient clients[maxStreamClients];
+	// frames published so far
+	uint32_t frames;
+	// last published frame, the base of the next delta
+	unsigned char previous[SW * SH];
+	// encoded delta and whole frame, reused every frame
+	std::vector<unsigned char> delta, key;
+	// bytes sent over all viewers
+	long long bytesSent;
+};
+
+// the viewer side of a stream
+struct StreamReader {
+	intptr_t socket;
+	// frame built up from every message so far
+	unsigned char frame[SW * SH];
+	// number of the last frame received
+	uint32_t number;
+	// bytes received
+	long long bytesReceived;
+	std::vector<unsigned char> message;
+};
+
+// encode the tiles of frame that differ from previous, or every tile if key; returns the message size
+int streamEncode(const unsigned char* previous, const unsigned char* frame, uint32_t number, bool key, unsigned char* message);
+// apply a whole message to frame, false if it is malformed; number is the message's frame number
+bool streamDecode(const unsigned char* message, int size, unsigned char* frame, uint32_t* number);
+
+// listen for viewers on port of every interface, 0 picks a free port
+bool streamServerStart(StreamServer* server, int port);
+// wait up to timeout milliseconds for a viewer to connect, true once one has
+bool streamServerWait(StreamServer* server, int timeout);
+// take new viewers and send them the frame, whole to new ones and as changed tiles to the rest
+void streamPublish(StreamServer* server, const unsigned char* frame);
+// number of connected viewers
+int streamClients(const StreamServer* server);
+void streamServerStop(StreamServer* server);
+
+// connect to a server at host and port
+bool streamConnect(StreamReader* reader, const char* host, int port);
+// wait for the next message and apply it to reader->frame, false once the server is gone
+bool streamReceive(StreamReader* reader);
+void streamDisconnect(StreamReader* reader);
@@ -0,0 +1,73 @@
+#include "triplebuffer.h"
+
+#include <chrono>
+#include <cstring>
+
+void tripleInit(TripleBuffer* buffer) {
+	memset(buffer->frames, 0, sizeof(buffer->frames));
+	memset(buffer->stamps, 0, sizeof(buffer->stamps));
+	buffer->back = 0;
+	buffer->middle.store(1);
+	buffer->front = 2;
+	buffer->published = 0;
+	buffer->dropped = 0;
+	buffer->closed = false;
+}
+
+unsigned char* tripleBack(TripleBuffer* buffer) {
+	return buffer->frames[buffer->back];
+}
+
+void triplePublish(TripleBuffer* buffer, int64_t stamp) {
+	buffer->stamps[buffer->back] = stamp;
+	// release hands the frame over, acquire takes back whichever buffer the consumer left
+	int old = buffer->middle.exchange(buffer->back | tripleFresh, std::memory_order_acq_rel);
+	if (old & tripleFresh) {
+		buffer->dropped++;
+	}
+	buffer->back = old & ~tripleFresh;
+	buffer->published++;
+	// taking the lock orders the exchange with a consumer about to sleep, so the wake is not lost
+	{
+		std::lock_guard<std::mutex> guard(buffer->lock);
+	}
+	buffer->cv.notify_all();
+}
+
+bool tripleTake(TripleBuffer* buffer) {
+	// only the consumer clears tripleFresh, so it is still set at the exchange
+	if (!(buffer->middle.load(std::memory_order_relaxed) & tripleFresh)) {
+		return false;
+	}
+	int old = buffer->middle.exchange(buffer->front, std::memory_order_acq_rel);
+	buffer->front = old & ~tripleFresh;
+	return true;
+}
+
+const unsigned char* tripleFront(const TripleBuffer* buffer) {
+	return buffer->frames[buffer->front];
+}
+
+int64_t tripleStamp(const TripleBuffer* buffer) {
+	return buffer->stamps[buffer->front];
+}
+
+bool tripleWait(TripleBuffer* buffer, int timeout) {
+	std::unique_lock<std::mutex> guard(buffer->lock);
+	buffer->cv.wait_for(guard, std::chrono::milliseconds(timeout),
+		[buffer] { return (buffer->middle.load(std::memory_order_relaxed) & tripleFresh) || buffer->closed; });
+	return !buffer->closed && (buffer->middle.load(std::memory_order_relaxed) & tripleFresh);
+}
+
+void tripleClose(TripleBuffer* buffer) {
+	{
+		std::lock_guard<std::mutex> guard(buffer->lock);
+		buffer->closed = true;
+	}
+	buffer->cv.notify_all();
+}
+
+bool tripleClosed(TripleBuffer* buffer) {
+	std::lock_guard<std::mutex> guard(buffer->lock);
+	return buffer->closed;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "types.h"
+
+// defines for triple buffer settings
+#define tripleFresh        4                       // set in middle while the consumer has not taken it
+
+// hands finished frames from one producer to one consumer without either waiting on the other.
+// the producer always has a buffer to write and the consumer always has one to read, the third
+// holds the newest finished frame; publishing swaps it with the producer's, so a frame the
+// consumer was too slow to take is dropped in favor of the newer one
+struct TripleBuffer {
+	// palette colors, row 0 is the bottom of the screen
+	unsigned char frames[3][SW * SH];
+	// stamp given with each frame when it was published
+	int64_t stamps[3];
+	// buffer the producer writes, only touched by the producer
+	int back;
+	// buffer the consumer reads, only touched by the consumer
+	int front;
+	// newest finished buffer, with tripleFresh set until the consumer takes it
+	std::atomic<int> middle;
+	// frames published, and those replaced before the consumer took them; only touched by the producer
+	long long published, dropped;
+	// the consumer sleeps here in tripleWait()
+	std::mutex lock;
+	std::condition_variable cv;
+	bool closed;
+};
+
+// empty the buffers, only while neither side is using them
+void tripleInit(TripleBuffer* buffer);
+// buffer the producer writes the next frame into
+unsigned char* tripleBack(TripleBuffer* buffer);
+// finish the frame in the back buffer, it replaces any frame the consumer has not taken yet
+void triplePublish(TripleBuffer* buffer, int64_t stamp);
+// make the newest finished frame the front buffer, false if none was published since the last take
+bool tripleTake(TripleBuffer* buffer);
+// frame the consumer took last and its stamp
+const unsigned char* tripleFront(const TripleBuffer* buffer);
+int64_t tripleStamp(const TripleBuffer* buffer);
+// wait up to timeout milliseconds for a frame the consumer has not taken, false on timeout or once closed
+bool tripleWait(TripleBuffer* buffer, int timeout);
+// wake the consumer for good, it stops waiting for frames
+void tripleClose(TripleBuffer* buffer);
+// true once tripleClose() was called
+bool tripleClosed(TripleBuffer* buffer);
@@ -0,0 +1,74 @@
+#pragma once
+
+// defines for window settings
+#define res                1                       // window resolution: 1=200x150 2=400x300 4=800x600
+#define SW                 200*res                 // screen width
+#define SH                 150*res                 // screen height
+#define SW2                (SW/2)                  // half of screen width
+#define SH2                (SH/2)                  // half of screen height
+#define pixelScale         4/res                   // OpenGL pixel scale
+#define GLSW               (SW*pixelScale)         // OpenGL window width
+#define GLSH               (SH*pixelScale)         // OpenGL window height
+
+// defines for math constants
+#define PI                 (3.1415926535897932f)   // pi constant
+
+// defines for game variables
+#define maxSect            1024                    // most sectors a map can have
+#define maxWall            4096                    // most walls a map can have
+
+struct Time {
+	int frame1, frame2;
+};
+
+struct Keys {
+	// move up, down, left, right
+	int w, a, s, d;
+	// strafe left, right
+	int strafeL, strafeR;
+	// move up, down, look up, down
+	int mlook;
+	// jump
+	int jump;
+	// 1 to fly with mlook instead of falling, toggled rather than held
+	int fly;
+};
+
+struct Rotation {
+	// save sin and cos as values 0-360 degrees
+	float cos[360];
+	float sin[360];
+};
+
+struct Player {
+	// player position
+	int x, y, z;
+	// player angle of rotation
+	int angle;
+	// variable to look up and down
+	int look;
+	// sector the player is in, -1 outside every sector
+	int sector;
+	// vertical speed
+	int velZ;
+};
+
+struct Wall {
+	// bottom line point 1
+	int x1, y1;
+	// bottom line point 2
+	int x2, y2;
+	// wall color
+	int color;
+};
+
+struct Sector {
+	// wall number start and end
+	int wallStart, wallEnd;
+	// height of bottom and top
+	int z1, z2;
+	// center position of sector
+	int x, y;
+	// bottom and top colors
+	int colorBot, colorTop;
+};
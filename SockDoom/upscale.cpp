@@ -0,0 +1,188 @@
+#include "upscale.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "jobs.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define hasSSE2            1
+#else
+#define hasSSE2            0
+#endif
+
+// one pass of an upscale, handed to the job threads
+struct UpscaleJob {
+	const unsigned char* src;
+	int width, height;
+	int factor;
+	unsigned char* dst;
+};
+
+// repeat every pixel of a row factor times
+static void nearestRow(const unsigned char* src, int width, int factor, unsigned char* dst) {
+	int x = 0;
+
+#if hasSSE2
+	// interleaving a vector with itself doubles each byte, once per doubling of the factor
+	if (factor == 2) {
+		for (; x + 16 <= width; x += 16) {
+			__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2), _mm_unpacklo_epi8(p, p));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x * 2 + 16), _mm_unpackhi_epi8(p, p));
+		}
+	}
+	else if (factor == 4 || factor == 8) {
+		for (; x + 16 <= width; x += 16) {
+			__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + x));
+			__m128i low = _mm_unpacklo_epi8(p, p), high = _mm_unpackhi_epi8(p, p);
+			__m128i quads[4] = { _mm_unpacklo_epi16(low, low), _mm_unpackhi_epi16(low, low),
+				_mm_unpacklo_epi16(high, high), _mm_unpackhi_epi16(high, high) };
+			__m128i* out = reinterpret_cast<__m128i*>(dst + x * factor);
+			for (int q = 0; q < 4; q++) {
+				if (factor == 4) {
+					_mm_storeu_si128(out + q, quads[q]);
+				}
+				else {
+					_mm_storeu_si128(out + q * 2, _mm_unpacklo_epi32(quads[q], quads[q]));
+					_mm_storeu_si128(out + q * 2 + 1, _mm_unpackhi_epi32(quads[q], quads[q]));
+				}
+			}
+		}
+	}
+#endif
+	for (; x < width; x++) {
+		memset(dst + x * factor, src[x], factor);
+	}
+}
+
+static void nearestRows(int begin, int end, void* data) {
+	const UpscaleJob* job = static_cast<const UpscaleJob*>(data);
+	int outWidth = job->width * job->factor;
+	int y, k;
+
+	for (y = begin; y < end; y++) {
+		unsigned char* first = job->dst + y * job->factor * outWidth;
+		nearestRow(job->src + y * job->width, job->width, job->factor, first);
+		for (k = 1; k < job->factor; k++) {
+			memcpy(first + k * outWidth, first, outWidth);
+		}
+	}
+}
+
+// scale2x of one pixel from its neighbors on screen: a above, b right, c left, d below.
+// a corner takes the color of the two neighbors beside it when they match and the other two do not,
+// which keeps diagonal edges sharp instead of stepped
+static void scale2xPixel(const unsigned char* row, const unsigned char* above, const unsigned char* below, int width, int x,
+	unsigned char* upper, unsigned char* lower) {
+	int p = row[x];
+	int a = above[x], d = below[x];
+	int c = row[(x > 0) ? x - 1 : x], b = row[(x + 1 < width) ? x + 1 : x];
+
+	upper[x * 2] = static_cast<unsigned char>((c == a && c != d && a != b) ? a : p);
+	upper[x * 2 + 1] = static_cast<unsigned char>((a == b && a != c && b != d) ? b : p);
+	lower[x * 2] = static_cast<unsigned char>((d == c && d != b && c != a) ? c : p);
+	lower[x * 2 + 1] = static_cast<unsigned char>((b == d && b != a && d != c) ? d : p);
+}
+
+#if hasSSE2
+// pick a where mask is set, b elsewhere
+static inline __m128i selectBytes(__m128i mask, __m128i a, __m128i b) {
+	return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+#endif
+
+static void scale2xRows(int begin, int end, void* data) {
+	const UpscaleJob* job = static_cast<const UpscaleJob*>(data);
+	int width = job->width;
+	int y;
+
+	for (y = begin; y < end; y++) {
+		// row 0 is the bottom, so the row above on screen is the next one; edges repeat themselves
+		const unsigned char* row = job->src + y * width;
+		const unsigned char* above = job->src + ((y + 1 < job->height) ? y + 1 : y) * width;
+		const unsigned char* below = job->src + ((y > 0) ? y - 1 : y) * width;
+		unsigned char* lower = job->dst + y * 2 * width * 2;
+		unsigned char* upper = lower + width * 2;
+		int x = 0;
+
+		scale2xPixel(row, above, below, width, x, upper, lower);
+		x++;
+#if hasSSE2
+		// the same tests on 16 pixels at once, the neighbors left and right come from unaligned loads
+		for (; x + 17 <= width; x += 16) {
+			__m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(above + x));
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(below + x));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x - 1));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x + 1));
+			__m128i ca = _mm_cmpeq_epi8(c, a), cd = _mm_cmpeq_epi8(c, d);
+			__m128i ab = _mm_cmpeq_epi8(a, b), bd = _mm_cmpeq_epi8(b, d);
+			__m128i e0 = selectBytes(_mm_andnot_si128(ab, _mm_andnot_si128(cd, ca)), a, p);
+			__m128i e1 = selectBytes(_mm_andnot_si128(bd, _mm_andnot_si128(ca, ab)), b, p);
+			__m128i e2 = selectBytes(_mm_andnot_si128(ca, _mm_andnot_si128(bd, cd)), c, p);
+			__m128i e3 = selectBytes(_mm_andnot_si128(cd, _mm_andnot_si128(ab, bd)), d, p);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(upper + x * 2), _mm_unpacklo_epi8(e0, e1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(upper + x * 2 + 16), _mm_unpackhi_epi8(e0, e1));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lower + x * 2), _mm_unpacklo_epi8(e2, e3));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(lower + x * 2 + 16), _mm_unpackhi_epi8(e2, e3));
+		}
+#endif
+		for (; x < width; x++) {
+			scale2xPixel(row, above, below, width, x, upper, lower);
+		}
+	}
+}
+
+void upscaleNearest(const unsigned char* src, int width, int height, int factor, unsigned char* dst) {
+	UpscaleJob job = { src, width, height, factor, dst };
+	parallelFor(height, upscaleGrain, nearestRows, &job);
+}
+
+void upscaleScale2x(const unsigned char* src, int width, int height, unsigned char* dst) {
+	UpscaleJob job = { src, width, height, 2, dst };
+	parallelFor(height, upscaleGrain, scale2xRows, &job);
+}
+
+bool upscaleInit(Upscaler* upscaler, int factor, int filter) {
+	if (factor < 1 || factor > maxUpscale) {
+		std::cout << "Upscale factor must be 1 to " << maxUpscale << std::endl;
+		return false;
+	}
+	if (filter == UPSCALE_SCALE2X && factor != 2 && factor != 4 && factor != 8) {
+		std::cout << "scale2x needs an upscale factor of 2, 4 or 8" << std::endl;
+		return false;
+	}
+	upscaler->factor = factor;
+	upscaler->filter = filter;
+	upscaler->width = SW * factor;
+	upscaler->height = SH * factor;
+	upscaler->out.resize(upscaler->width * upscaler->height);
+	// every pass but the last writes here, each twice the size of the one before
+	int scratch = 0;
+	int size;
+	if (filter == UPSCALE_SCALE2X) {
+		for (size = 2; size < factor; size *= 2) {
+			scratch += SW * size * SH * size;
+		}
+	}
+	upscaler->scratch.resize(scratch);
+	return true;
+}
+
+void upscaleFrame(Upscaler* upscaler, const unsigned char* frame) {
+	if (upscaler->filter != UPSCALE_SCALE2X) {
+		upscaleNearest(frame, SW, SH, upscaler->factor, upscaler->out.data());
+		return;
+	}
+	const unsigned char* src = frame;
+	unsigned char* scratch = upscaler->scratch.data();
+	int size;
+	for (size = 1; size * 2 < upscaler->factor; size *= 2) {
+		upscaleScale2x(src, SW * size, SH * size, scratch);
+		src = scratch;
+		scratch += SW * size * 2 * SH * size * 2;
+	}
+	upscaleScale2x(src, SW * size, SH * size, upscaler->out.data());
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+
+#include "types.h"
+
+// defines for upscaler settings
+#define maxUpscale         8                       // largest whole number a frame is scaled up by
+#define upscaleGrain       8                       // source rows per job
+#define UPSCALE_NEAREST    0                       // each pixel becomes a square of its color
+#define UPSCALE_SCALE2X    1                       // scale2x (epx) once per doubling, for factors 2, 4 and 8
+
+// scales palette frames up by a whole number before they become rgb, so every pass moves one byte
+// per pixel. rows are spread over the job threads and the common cases use sse2 where it is available
+struct Upscaler {
+	int factor;
+	int filter;
+	// size of the output
+	int width, height;
+	// scaled frame, palette colors with row 0 at the bottom
+	std::vector<unsigned char> out;
+	// frames between the passes of a repeated scale2x
+	std::vector<unsigned char> scratch;
+};
+
+// set up for a factor and filter, false if the filter cannot scale by factor
+bool upscaleInit(Upscaler* upscaler, int factor, int filter);
+// scale a SW x SH frame into upscaler->out
+void upscaleFrame(Upscaler* upscaler, const unsigned char* frame);
+
+// single passes over an image of any size, row 0 at the bottom; dst is width * factor by
+// height * factor for nearest and twice the size each way for scale2x
+void upscaleNearest(const unsigned char* src, int width, int height, int factor, unsigned char* dst);
+void upscaleScale2x(const unsigned char* src, int width, int height, unsigned char* dst);
@@ -0,0 +1,110 @@
+#include "vecenv.h"
+
+#include <iostream>
+
+#include "actor.h"
+#include "jobs.h"
+#include "render.h"
+
+// arguments of one vecEnvStep, shared by its jobs
+struct VecEnvStep {
+	VecEnv* env;
+	const Keys* actions;
+	unsigned char* observations;
+	float* depth;
+};
+
+bool vecEnvInit(VecEnv* env, int count, int channels, const char* mapPath) {
+	int i;
+
+	if (count < 1 || count > maxEnvs) {
+		std::cout << "Cannot step " << count << " engines, the limit is " << maxEnvs << std::endl;
+		return false;
+	}
+	if (channels != OBS_PALETTE && channels != OBS_RGB) {
+		std::cout << "Observations have " << OBS_PALETTE << " or " << OBS_RGB << " channels, not " << channels << std::endl;
+		return false;
+	}
+	for (i = 0; i < 256; i++) {
+		paletteColor(i, env->paletteRGB[i]);
+	}
+
+	env->count = 0;
+	env->channels = channels;
+	for (i = 0; i < count; i++) {
+		env->engines[i] = createEngine();
+		env->count++;
+		if (mapPath != nullptr && !loadMap(env->engines[i], mapPath)) {
+			vecEnvFree(env);
+			return false;
+		}
+	}
+	return true;
+}
+
+void vecEnvFree(VecEnv* env) {
+	int i;
+
+	for (i = 0; i < env->count; i++) {
+		destroyEngine(env->engines[i]);
+	}
+	env->count = 0;
+}
+
+void vecEnvReset(VecEnv* env, int index) {
+	Engine* engine = env->engines[index];
+
+	setMap(engine, engine->map);
+}
+
+size_t vecEnvObservationSize(const VecEnv* env) {
+	return static_cast<size_t>(env->count) * SH * SW * env->channels;
+}
+
+static void stepRange(int begin, int end, void* data) {
+	const VecEnvStep* step = static_cast<const VecEnvStep*>(data);
+	VecEnv* env = step->env;
+	int i, p;
+
+	for (i = begin; i < end; i++) {
+		Engine* engine = env->engines[i];
+		unsigned char* slot = step->observations + static_cast<size_t>(i) * SH * SW * env->channels;
+
+		engine->keys = step->actions[i];
+		movePlayer(engine);
+		thinkActors(engine);
+		moveActors(engine);
+
+		// palette observations are the frame buffer itself
+		if (env->channels == OBS_PALETTE) {
+			engine->view.frameBuffer = slot;
+		}
+		engine->view.depthBuffer = (step->depth != nullptr) ? step->depth + static_cast<size_t>(i) * SH * SW : nullptr;
+		resetRenderStats(&engine->view.renderStats);
+		clearBackground(&engine->view);
+		draw3D(engine, &engine->player);
+		arenaReset(&engine->view.frameArena);
+		engine->view.frameBuffer = engine->view.frameStorage;
+		engine->view.depthBuffer = nullptr;
+
+		if (env->channels == OBS_RGB) {
+			for (p = 0; p < SW * SH; p++) {
+				const unsigned char* rgb = env->paletteRGB[engine->view.frameStorage[p]];
+				slot[p * 3 + 0] = rgb[0];
+				slot[p * 3 + 1] = rgb[1];
+				slot[p * 3 + 2] = rgb[2];
+			}
+		}
+	}
+}
+
+void vecEnvStep(VecEnv* env, const Keys* actions, unsigned char* observations, float* depth) {
+	VecEnvStep step;
+
+	step.env = env;
+	step.actions = actions;
+	step.observations = observations;
+	step.depth = depth;
+	// one engine per job, each engine's actors can still split further
+	parallelFor(env->count, 1, stepRange, &step);
+}
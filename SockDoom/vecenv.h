@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+#include "engine.h"
+
+// defines for vectorized environment settings
+#define maxEnvs            256                     // most engines stepped together
+#define OBS_PALETTE        1                       // observation channels: the palette color of each pixel
+#define OBS_RGB            3                       // observation channels: red, green and blue of each pixel
+
+// many engines on one map stepped together, for agent training. a step takes keys for every
+// engine and renders each straight into its slot of the caller's observation tensor, so
+// stepping allocates nothing and, for OBS_PALETTE, copies nothing
+struct VecEnv {
+	int count;
+	// OBS_PALETTE or OBS_RGB
+	int channels;
+	Engine* engines[maxEnvs];
+	// rgb of every palette color, for OBS_RGB
+	unsigned char paletteRGB[256][3];
+};
+
+// create count engines on a map, nullptr for the built-in map; the engines share one copy of it
+bool vecEnvInit(VecEnv* env, int count, int channels, const char* mapPath);
+void vecEnvFree(VecEnv* env);
+// put one engine back at the start of its map, without actors
+void vecEnvReset(VecEnv* env, int index);
+// bytes in the observation tensor, count x SH x SW x channels
+size_t vecEnvObservationSize(const VecEnv* env);
+// advance every engine one tick with its keys in actions, then render engine i into
+// observations + i * SH * SW * channels and, unless depth is nullptr, its view space distances
+// into depth + i * SH * SW. row 0 of each slot is the bottom of the screen, like the frame buffer.
+// the engines are spread over the job threads
+void vecEnvStep(VecEnv* env, const Keys* actions, unsigned char* observations, float* depth);
@@ -0,0 +1,608 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "actor.h"
+#include "capture.h"
+#include "demo.h"
+#include "engine.h"
+#include "input.h"
+#include "jobs.h"
+#include "pipeline.h"
+#include "profiler.h"
+#include "render.h"
+#include "stream.h"
+#include "upscale.h"
+#include "vecenv.h"
+
+// defines for benchmark settings
+#define defaultFrames      2000                    // frames rendered per camera path
+
+// engine every run uses
+Engine* engine;
+// frames of the timedemo's first instance, written when --capture or --capture-rgb is given
+Capture capture;
+// viewers of the timedemo's first instance when --serve is given, which plays it in real time
+StreamServer server;
+bool serving;
+// center of the loaded map and the distance the camera paths keep from it
+int centerX, centerY, reach;
+
+struct CameraPath {
+	// name used by --path and in the report
+	const char* name;
+	// write the x, y, z, angle, look of a frame along the path
+	void (*pose)(int frame, int frames, int pose[5]);
+};
+
+// circle the map looking at its center
+void orbitPath(int frame, int frames, int pose[5]) {
+	int angle = frame * 360 / frames;
+	pose[0] = centerX - static_cast<int>(engine->rot->sin[angle] * reach);
+	pose[1] = centerY - static_cast<int>(engine->rot->cos[angle] * reach);
+	pose[2] = 20;
+	pose[3] = angle;
+	pose[4] = 0;
+}
+
+// walk forward through the map, clipping walls that pass the player
+void walkPath(int frame, int frames, int pose[5]) {
+	pose[0] = centerX;
+	pose[1] = centerY - reach + frame * 2 * reach / frames;
+	pose[2] = 20;
+	pose[3] = 0;
+	pose[4] = 0;
+}
+
+// turn on the spot in the middle of the map
+void spinPath(int frame, int frames, int pose[5]) {
+	pose[0] = centerX;
+	pose[1] = centerY;
+	pose[2] = 20;
+	pose[3] = frame * 360 / frames;
+	pose[4] = 0;
+}
+
+// rise from below the floors to above the ceilings while looking up and down
+void lookPath(int frame, int frames, int pose[5]) {
+	int angle = frame * 360 / frames;
+	pose[0] = centerX;
+	pose[1] = centerY - reach;
+	pose[2] = -20 + frame * 100 / frames;
+	pose[3] = 0;
+	pose[4] = static_cast<int>(engine->rot->sin[angle] * 15);
+}
+
+CameraPath paths[] = {
+	{ "orbit", orbitPath },
+	{ "walk",  walkPath },
+	{ "spin",  spinPath },
+	{ "look",  lookPath },
+};
+
+#define numPaths           (int)(sizeof(paths) / sizeof(paths[0]))
+
+// load the map and place the camera paths around its walls
+bool loadBenchMap(const char* mapPath) {
+	int w;
+
+	init(engine);
+	if (mapPath != nullptr && !loadMap(engine, mapPath)) {
+		return false;
+	}
+
+	const Wall* walls = engine->map->walls;
+	int numWall = engine->map->numWall;
+	int minX = walls[0].x1, maxX = walls[0].x1, minY = walls[0].y1, maxY = walls[0].y1;
+	for (w = 0; w < numWall; w++) {
+		minX = std::min(minX, std::min(walls[w].x1, walls[w].x2));
+		maxX = std::max(maxX, std::max(walls[w].x1, walls[w].x2));
+		minY = std::min(minY, std::min(walls[w].y1, walls[w].y2));
+		maxY = std::max(maxY, std::max(walls[w].y1, walls[w].y2));
+	}
+	centerX = (minX + maxX) / 2;
+	centerY = (minY + maxY) / 2;
+	reach = std::max(maxX - minX, maxY - minY) / 2 + 112;
+	return true;
+}
+
+// render every frame of a path and print its timings and render statistics
+bool runPath(const CameraPath* path, const char* mapPath, int frames, std::vector<long long>* times) {
+	int f;
+	int pose[5];
+	long long total = 0;
+	// render statistics summed over the path
+	long long walls = 0, culled = 0, clipped = 0, columns = 0, clamped = 0, pixels = 0;
+
+	if (!loadBenchMap(mapPath)) {
+		return false;
+	}
+	for (f = 0; f < frames; f++) {
+		path->pose(f, frames, pose);
+		setPose(engine, pose);
+
+		auto start = std::chrono::steady_clock::now();
+		resetRenderStats(&engine->view.renderStats);
+		clearBackground(&engine->view);
+		draw3D(engine, &engine->player);
+		arenaReset(&engine->view.frameArena);
+		(*times)[f] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		total += (*times)[f];
+
+		if (statsEnabled) {
+			walls += engine->view.renderStats.wallsConsidered;
+			culled += engine->view.renderStats.wallsCulled;
+			clipped += engine->view.renderStats.wallsClipped;
+			columns += engine->view.renderStats.columns;
+			clamped += engine->view.renderStats.columnsClamped;
+			pixels += statsPixelsWritten(&engine->view.renderStats);
+		}
+	}
+
+	std::sort(times->begin(), times->begin() + frames);
+	printf("%-6s %6d frames  avg %8.1f us  p50 %8.1f us  p99 %8.1f us  max %8.1f us  %9.0f fps\n", path->name, frames,
+		total / 1000.0 / frames, (*times)[frames / 2] / 1000.0, (*times)[frames * 99 / 100] / 1000.0, (*times)[frames - 1] / 1000.0,
+		1e9 * frames / total);
+
+	if (statsEnabled) {
+		printf("       per frame: walls %lld culled %lld clipped %lld  columns %lld clamped %lld  pixels %lld  overdraw %.2f\n",
+			walls / frames, culled / frames, clipped / frames, columns / frames, clamped / frames, pixels / frames,
+			static_cast<double>(pixels) / frames / (SW * SH));
+	}
+	return true;
+}
+
+// load the map and spread actors over it in a square grid around the center, with the player
+// in the middle so some actors chase
+bool loadBenchActors(const char* mapPath, int count) {
+	int i;
+
+	if (!loadBenchMap(mapPath)) {
+		return false;
+	}
+	int side = 1;
+	while (side * side < count) {
+		side++;
+	}
+	for (i = 0; i < count; i++) {
+		int x = centerX - reach + (i % side) * 2 * reach / side;
+		int y = centerY - reach + (i / side) * 2 * reach / side;
+		if (spawnActor(engine, x, y, i * 37).slot < 0) {
+			return false;
+		}
+	}
+	int pose[5] = { centerX, centerY, 20, 0, 0 };
+	setPose(engine, pose);
+	return true;
+}
+
+// time the actor systems for the given number of ticks
+bool runActors(const char* mapPath, int count, int ticks, std::vector<long long>* times) {
+	int t;
+	long long total = 0;
+
+	if (!loadBenchActors(mapPath, count)) {
+		return false;
+	}
+	for (t = 0; t < ticks; t++) {
+		auto start = std::chrono::steady_clock::now();
+		thinkActors(engine);
+		moveActors(engine);
+		(*times)[t] = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		total += (*times)[t];
+	}
+
+	std::sort(times->begin(), times->begin() + ticks);
+	printf("actors %6d ticks   avg %8.1f us  p50 %8.1f us  p99 %8.1f us  max %8.1f us  %6.1f ns/actor (%d actors)\n", ticks,
+		total / 1000.0 / ticks, (*times)[ticks / 2] / 1000.0, (*times)[ticks * 99 / 100] / 1000.0, (*times)[ticks - 1] / 1000.0,
+		static_cast<double>(total) / ticks / count, count);
+	return true;
+}
+
+// time frames of simulating and rendering one after the other, then with the pipeline overlapping them
+bool runPipeline(const char* mapPath, int count, int frames) {
+	static Pipeline pipeline;
+	InputLatency latency;
+	int f;
+	Keys input = Keys();
+	input.a = 1;
+
+	if (!loadBenchActors(mapPath, count)) {
+		return false;
+	}
+	auto start = std::chrono::steady_clock::now();
+	for (f = 0; f < frames; f++) {
+		resetRenderStats(&engine->view.renderStats);
+		clearBackground(&engine->view);
+		draw3D(engine, &engine->player);
+		arenaReset(&engine->view.frameArena);
+		engine->keys = input;
+		movePlayer(engine);
+		thinkActors(engine);
+		moveActors(engine);
+	}
+	long long serial = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+	if (!loadBenchActors(mapPath, count)) {
+		return false;
+	}
+	start = std::chrono::steady_clock::now();
+	// an event every frame measures how long input takes to reach a finished frame
+	latencyReset(&latency);
+	pipelineInit(&pipeline);
+	pipelineStart(&pipeline, engine);
+	for (f = 0; f < frames; f++) {
+		pipelineWait(&pipeline);
+		if (pipelineFrameState(&pipeline)->inputTime != 0) {
+			latencyRecord(&latency, profileNow() - pipelineFrameState(&pipeline)->inputTime);
+		}
+		inputPush(&pipeline.input, INPUT_A, 1);
+		pipelineKick(&pipeline, 0, RENDER_NORMAL, COLUMNS_FULL);
+	}
+	pipelineStop(&pipeline);
+	long long pipelined = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+	printf("frames %6d serial    avg %8.1f us  pipelined avg %8.1f us  input to frame avg %8.1f us worst %8.1f us (%d actors)\n",
+		frames, serial / 1000.0 / frames, pipelined / 1000.0 / frames, latencyAverage(&latency) / 1000.0,
+		latency.worst / 1000.0, count);
+	return true;
+}
+
+// step engines together for the given number of ticks, first with palette observations and then
+// with rgb and depth, and print engine steps per second
+bool runVecEnv(const char* mapPath, int count, int ticks) {
+	static VecEnv env;
+	int i, t, pass;
+	std::vector<Keys> actions(count);
+
+	for (pass = 0; pass < 2; pass++) {
+		int channels = (pass == 0) ? OBS_PALETTE : OBS_RGB;
+		if (!vecEnvInit(&env, count, channels, mapPath)) {
+			return false;
+		}
+		// allocated up front, as a training loop would
+		std::vector<unsigned char> observations(vecEnvObservationSize(&env));
+		std::vector<float> depth((pass == 0) ? 0 : count * SW * SH);
+
+		auto start = std::chrono::steady_clock::now();
+		for (t = 0; t < ticks; t++) {
+			for (i = 0; i < count; i++) {
+				actions[i] = Keys();
+				actions[i].w = 1;
+				actions[i].a = (t / 20 + i) % 2;
+			}
+			vecEnvStep(&env, actions.data(), observations.data(), (pass == 0) ? nullptr : depth.data());
+		}
+		long long total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		vecEnvFree(&env);
+
+		printf("envs   %6d ticks   %-13s avg %8.1f us/step  %9.0f engine steps/s (%d engines)\n", ticks,
+			(pass == 0) ? "palette" : "rgb + depth", total / 1000.0 / ticks, total > 0 ? 1e9 * ticks * count / total : 0.0, count);
+	}
+	return true;
+}
+
+// render count cameras spread around the orbit path for as many frames, first one after another
+// with draw3D() on the shared engine, then as one drawViews() batch per frame
+bool runCameras(const char* mapPath, int count, int frames) {
+	int i, f, pass;
+	int pose[5];
+	std::vector<Player> cameras(count);
+	std::vector<View*> views(count);
+
+	if (!loadBenchMap(mapPath)) {
+		return false;
+	}
+	for (i = 0; i < count; i++) {
+		views[i] = createView();
+	}
+
+	for (pass = 0; pass < 2; pass++) {
+		auto start = std::chrono::steady_clock::now();
+		for (f = 0; f < frames; f++) {
+			for (i = 0; i < count; i++) {
+				orbitPath((f + i * frames / count) % frames, frames, pose);
+				cameras[i] = Player();
+				cameras[i].x = pose[0];
+				cameras[i].y = pose[1];
+				cameras[i].z = pose[2];
+				cameras[i].angle = pose[3];
+				cameras[i].look = pose[4];
+			}
+			if (pass == 1) {
+				drawViews(engine, cameras.data(), views.data(), count);
+				continue;
+			}
+			for (i = 0; i < count; i++) {
+				resetRenderStats(&engine->view.renderStats);
+				clearBackground(&engine->view);
+				draw3D(engine, &cameras[i]);
+				arenaReset(&engine->view.frameArena);
+			}
+		}
+		long long total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+		printf("cameras %5d frames  %-13s avg %8.1f us/frame %9.0f camera-frames/s (%d cameras)\n", frames,
+			(pass == 0) ? "draw3D each" : "drawViews", total / 1000.0 / frames, total > 0 ? 1e9 * frames * count / total : 0.0, count);
+	}
+
+	for (i = 0; i < count; i++) {
+		destroyView(views[i]);
+	}
+	return true;
+}
+
+// time scaling one frame up to output sizes, each way the headless renderer can
+bool runUpscale(const char* mapPath, int frames) {
+	static Upscaler upscaler;
+	static const int modes[][2] = {
+		{ 4, UPSCALE_NEAREST }, { 8, UPSCALE_NEAREST }, { 2, UPSCALE_SCALE2X }, { 4, UPSCALE_SCALE2X }, { 8, UPSCALE_SCALE2X },
+	};
+	int m, f;
+	int pose[5];
+
+	if (!loadBenchMap(mapPath)) {
+		return false;
+	}
+	orbitPath(0, frames, pose);
+	setPose(engine, pose);
+	renderStill(engine);
+
+	for (m = 0; m < static_cast<int>(sizeof(modes) / sizeof(modes[0])); m++) {
+		if (!upscaleInit(&upscaler, modes[m][0], modes[m][1])) {
+			return false;
+		}
+		auto start = std::chrono::steady_clock::now();
+		for (f = 0; f < frames; f++) {
+			upscaleFrame(&upscaler, engine->view.frameBuffer);
+		}
+		long long total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+		printf("upscale %5d frames  %dx %-8s %4dx%-4d avg %8.1f us/frame\n", frames, upscaler.factor,
+			(upscaler.filter == UPSCALE_SCALE2X) ? "scale2x" : "nearest", upscaler.width, upscaler.height, total / 1000.0 / frames);
+	}
+	return true;
+}
+
+// play every tick of a demo on one engine, rendering each tick
+void playTimedemo(Engine* instance, const Demo* demo) {
+	int t;
+	auto start = std::chrono::steady_clock::now();
+
+	for (t = 0; t < demo->numTicks; t++) {
+		resetRenderStats(&instance->view.renderStats);
+		clearBackground(&instance->view);
+		draw3D(instance, &instance->player);
+		arenaReset(&instance->view.frameArena);
+		if (instance == engine) {
+			captureFrame(&capture, instance->view.frameBuffer);
+		}
+		if (instance == engine && serving) {
+			// a tick every 50 ms, as the demo was recorded
+			std::this_thread::sleep_until(start + std::chrono::milliseconds(50 * t));
+			streamPublish(&server, instance->view.frameBuffer);
+		}
+		demoTick(instance, demo, t);
+	}
+}
+
+// play a demo as fast as possible, rendering every tick, like doom's -timedemo; with more than one
+// instance every one plays it at once on its own engine and thread, sharing the map and trig tables
+bool runTimedemo(const char* demoPath, int instances) {
+	static Demo demo;
+	int i;
+
+	if (!demoRead(&demo, demoPath)) {
+		return false;
+	}
+	std::vector<Engine*> engines(instances);
+	engines[0] = engine;
+	for (i = 1; i < instances; i++) {
+		engines[i] = createEngine();
+	}
+	bool ok = true;
+	for (i = 0; i < instances && ok; i++) {
+		ok = demoStart(engines[i], &demo);
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	if (ok && instances == 1) {
+		playTimedemo(engine, &demo);
+	}
+	else if (ok) {
+		std::vector<std::thread> threads;
+		for (i = 0; i < instances; i++) {
+			threads.push_back(std::thread(playTimedemo, engines[i], &demo));
+		}
+		for (i = 0; i < instances; i++) {
+			threads[i].join();
+		}
+	}
+	long long total = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+	// engines do not share state, so every instance ends where the first one does
+	const Player* player = &engine->player;
+	for (i = 1; i < instances && ok; i++) {
+		const Player* other = &engines[i]->player;
+		if (other->x != player->x || other->y != player->y || other->z != player->z || other->angle != player->angle || other->look != player->look) {
+			std::cout << "Instance " << i << " ended at " << other->x << " " << other->y << " " << other->z << " " << other->angle << " "
+				<< other->look << ", out of sync with instance 0" << std::endl;
+			ok = false;
+		}
+	}
+	for (i = 1; i < instances; i++) {
+		destroyEngine(engines[i]);
+	}
+	if (!ok) {
+		return false;
+	}
+
+	// the end pose shows whether playback stayed in sync with the recording
+	printf("timedemo %s: %d ticks x %d instances in %.1f ms, %.0f fps, ends at %d %d %d %d %d\n", demoPath, demo.numTicks, instances,
+		total / 1e6, total > 0 ? 1e9 * demo.numTicks * instances / total : 0.0, player->x, player->y, player->z, player->angle, player->look);
+	return true;
+}
+
+// render each camera path headlessly, --frames <n> sets the path length, --path <name> runs one path,
+// --map <file.map> replaces the built-in map, --actors <n> also times n actors for as many ticks, alone
+// and pipelined with rendering, and --threads <n> sets the job threads, all cores by default.
+// --timedemo <file.dem> plays a demo uncapped instead and reports its frame rate, --instances <n>
+// plays it on n engines at once and --capture <file.y4m> or --capture-rgb <file.rgb> writes every frame
+// of the first one, "-" for stdout. --serve <port> waits for a viewer and streams the first one to it
+// in real time, see sockdoom --connect. --envs <n> also times n engines stepped together with observations
+// and --cameras <n> times n cameras rendered one by one and as one batch. --upscale also times scaling
+// frames up to 800x600 and 1600x1200, square pixels and scale2x. --columns <low|interlaced> draws the
+// camera paths with half the columns
+int main(int argc, char** argv) {
+	int frames = defaultFrames;
+	int numActors = 0;
+	int threads = 0;
+	int instances = 1;
+	int numEnvs = 0;
+	int numCameras = 0;
+	int upscale = 0;
+	int columns = COLUMNS_FULL;
+	const char* only = nullptr;
+	const char* mapPath = nullptr;
+	const char* timedemoPath = nullptr;
+	const char* capturePath = nullptr;
+	int captureFormat = CAPTURE_Y4M;
+	int servePort = -1;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) {
+			frames = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--path") == 0 && i + 1 < argc) {
+			only = argv[++i];
+		}
+		else if (strcmp(argv[i], "--map") == 0 && i + 1 < argc) {
+			mapPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--actors") == 0 && i + 1 < argc) {
+			numActors = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+			threads = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--timedemo") == 0 && i + 1 < argc) {
+			timedemoPath = argv[++i];
+		}
+		else if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+			instances = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--envs") == 0 && i + 1 < argc) {
+			numEnvs = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--capture") == 0 && i + 1 < argc) {
+			capturePath = argv[++i];
+			captureFormat = CAPTURE_Y4M;
+		}
+		else if (strcmp(argv[i], "--capture-rgb") == 0 && i + 1 < argc) {
+			capturePath = argv[++i];
+			captureFormat = CAPTURE_RGB;
+		}
+		else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+			servePort = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--cameras") == 0 && i + 1 < argc) {
+			numCameras = atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--upscale") == 0) {
+			upscale = 1;
+		}
+		else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc && strcmp(argv[i + 1], "low") == 0) {
+			columns = COLUMNS_LOW;
+			i++;
+		}
+		else if (strcmp(argv[i], "--columns") == 0 && i + 1 < argc && strcmp(argv[i + 1], "interlaced") == 0) {
+			columns = COLUMNS_INTERLACED;
+			i++;
+		}
+		else {
+			std::cout << "Unknown argument " << argv[i] << std::endl;
+			return -1;
+		}
+	}
+	if (frames < 1) {
+		frames = 1;
+	}
+	if (instances < 1) {
+		instances = 1;
+	}
+
+	jobsInit(threads);
+	engine = createEngine();
+	if (timedemoPath != nullptr) {
+		// every tick is kept, the timedemo only waits for the writer if all its buffers are queued
+		if (capturePath != nullptr && !captureOpen(&capture, capturePath, captureFormat, false)) {
+			destroyEngine(engine);
+			return -1;
+		}
+		if (servePort >= 0) {
+			if (!streamServerStart(&server, servePort)) {
+				destroyEngine(engine);
+				return -1;
+			}
+			std::cout << "Waiting for a viewer on port " << server.port << std::endl;
+			while (!streamServerWait(&server, 1000)) {
+			}
+			serving = true;
+		}
+		bool ok = runTimedemo(timedemoPath, instances);
+		if (serving) {
+			printf("Streamed %u frames, %lld bytes to %d viewers\n", server.frames, server.bytesSent, streamClients(&server));
+			streamServerStop(&server);
+		}
+		if (capturePath != nullptr) {
+			if (captureClose(&capture)) {
+				printf("Captured %lld frames to %s\n", capture.written, capturePath);
+			}
+			else {
+				std::cout << "Failed to write " << capturePath << std::endl;
+				ok = false;
+			}
+		}
+		destroyEngine(engine);
+		return ok ? 0 : -1;
+	}
+
+	// allocated up front so the timed loop does not touch the heap
+	std::vector<long long> times(frames);
+	engine->view.columnMode = columns;
+
+	printf("%s, %dx%d, render statistics %s, %d job threads, %s columns\n", mapPath != nullptr ? mapPath : "built-in map", SW, SH,
+		statsEnabled ? "on" : "compiled out", jobThreads(), (columns == COLUMNS_LOW) ? "low detail" : (columns == COLUMNS_INTERLACED) ? "interlaced" : "all");
+	for (i = 0; i < numPaths; i++) {
+		if (only == nullptr || strcmp(only, paths[i].name) == 0) {
+			if (!runPath(&paths[i], mapPath, frames, &times)) {
+				destroyEngine(engine);
+				return -1;
+			}
+		}
+	}
+	if (numActors > 0 && (!runActors(mapPath, numActors, frames, &times) || !runPipeline(mapPath, numActors, frames))) {
+		destroyEngine(engine);
+		return -1;
+	}
+	if (numEnvs > 0 && !runVecEnv(mapPath, numEnvs, frames)) {
+		destroyEngine(engine);
+		return -1;
+	}
+	if (numCameras > 0 && !runCameras(mapPath, numCameras, frames)) {
+		destroyEngine(engine);
+		return -1;
+	}
+	if (upscale && !runUpscale(mapPath, frames)) {
+		destroyEngine(engine);
+		return -1;
+	}
+
+	destroyEngine(engine);
+	return 0;
+}
@@ -0,0 +1,93 @@
+#include "actor.h"
+#include "engine.h"
+#include "tests.h"
+
+int actorTests(int argc, char** argv) {
+	int failures = 0;
+	int i, t;
+
+	// built-in map, the boxes are solid from 0 to 40
+	Engine* engine = createEngine();
+	CHECK(engine->actors.count == 0);
+	ActorHandle none = { 0, 0 };
+	CHECK(actorEntry(&engine->actors, none) == -1);
+
+	// handles stay valid while other actors come and go
+	ActorHandle a = spawnActor(engine, -40, -40, 0);
+	ActorHandle b = spawnActor(engine, -60, -40, 90);
+	ActorHandle c = spawnActor(engine, -80, -40, 450);
+	CHECK(engine->actors.count == 3);
+	CHECK(actorEntry(&engine->actors, c) == 2 && engine->actors.angle[2] == 90);
+	CHECK(removeActor(&engine->actors, a));
+	CHECK(!removeActor(&engine->actors, a));
+	CHECK(actorEntry(&engine->actors, a) == -1);
+	CHECK(engine->actors.count == 2);
+	// the last actor moved into the hole and its handle followed it
+	CHECK(actorEntry(&engine->actors, c) == 0 && engine->actors.x[0] == -80);
+	CHECK(actorEntry(&engine->actors, b) == 1 && engine->actors.x[1] == -60);
+
+	// the freed slot is reused with a new generation, so the old handle stays stale
+	ActorHandle d = spawnActor(engine, -100, -40, 0);
+	CHECK(d.slot == a.slot && d.generation != a.generation);
+	CHECK(actorEntry(&engine->actors, a) == -1 && actorEntry(&engine->actors, d) == 2);
+
+	// loading a map removes every actor and invalidates their handles
+	init(engine);
+	CHECK(engine->actors.count == 0 && actorEntry(&engine->actors, b) == -1 && actorEntry(&engine->actors, d) == -1);
+
+	// the table fills up and then refuses more
+	for (i = 0; i < maxActors; i++) {
+		spawnActor(engine, -200 - i % 100, -200 - i / 100, 0);
+	}
+	CHECK(engine->actors.count == maxActors);
+	CHECK(spawnActor(engine, -50, -50, 0).slot == -1);
+	init(engine);
+
+	// an actor walking into a box is stopped by its wall
+	ActorHandle walker = spawnActor(engine, 16, -30, 0);
+	int e = actorEntry(&engine->actors, walker);
+	engine->actors.velY[e] = actorSpeed;
+	for (t = 0; t < 10; t++) {
+		moveActors(engine);
+	}
+	CHECK(engine->actors.y[e] < 0 && engine->actors.y[e] > -30 && engine->actors.z[e] == 0);
+
+	// near the player an actor turns towards it, far away it wanders
+	int pose[5] = { 16, -100, 20, 0, 0 };
+	setPose(engine, pose);
+	thinkActors(engine);
+	CHECK(engine->actors.state[e] == ACTOR_CHASE);
+	CHECK(engine->actors.angle[e] == 180 && engine->actors.velY[e] == -actorSpeed);
+	pose[1] = -1000;
+	setPose(engine, pose);
+	thinkActors(engine);
+	CHECK(engine->actors.state[e] == ACTOR_WANDER && engine->actors.tics[e] == wanderTics);
+	// so it does 65536 units away, where the squared distance no longer fits in an int
+	pose[0] = engine->actors.x[e] + 65536;
+	pose[1] = engine->actors.y[e];
+	setPose(engine, pose);
+	engine->actors.tics[e] = wanderTics;
+	thinkActors(engine);
+	CHECK(engine->actors.state[e] == ACTOR_WANDER && engine->actors.tics[e] == wanderTics - 1);
+
+	// a crowd runs the same way every time
+	int sum[2] = { 0, 0 };
+	for (i = 0; i < 2; i++) {
+		init(engine);
+		for (t = 0; t < 100; t++) {
+			spawnActor(engine, -150 + t * 3, -150, t * 7);
+		}
+		for (t = 0; t < 50; t++) {
+			thinkActors(engine);
+			moveActors(engine);
+		}
+		for (t = 0; t < engine->actors.count; t++) {
+			sum[i] += engine->actors.x[t] * 3 + engine->actors.y[t];
+		}
+	}
+	CHECK(sum[0] == sum[1]);
+	destroyEngine(engine);
+
+	printf("actor: %d failures\n", failures);
+	return failures;
+}
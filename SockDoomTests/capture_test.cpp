@@ -0,0 +1,101 @@
+#include <cstring>
+#include <string>
+#include <vector>
+#include "capture.h"
+#include "render.h"
+#include "tests.h"
+
+// defines for capture test settings
+#define captureTestFrames  20                      // frames written, more than the buffers
+#define captureTestPath    "sockdoom_capture_test"  // file written and removed by the test
+
+// read a whole file, empty if it is missing
+static std::string readFile(const char* path) {
+	std::string data;
+	char chunk[4096];
+	size_t got;
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) {
+		return data;
+	}
+	while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+		data.append(chunk, got);
+	}
+	fclose(file);
+	return data;
+}
+
+// background with a yellow bottom row and frame number in the bottom left pixel
+static void testFrame(int number, unsigned char* frame) {
+	memset(frame, 8, SW * SH);
+	memset(frame, 0, SW);
+	frame[0] = static_cast<unsigned char>(number % 8);
+}
+
+int captureTests(int argc, char** argv) {
+	static Capture capture;
+	int failures = 0;
+	int i;
+	std::vector<unsigned char> frame(SW * SH);
+	unsigned char rgb[3];
+
+	// y4m: a header, then every frame behind its own frame header, top row first
+	CHECK(captureOpen(&capture, captureTestPath, CAPTURE_Y4M, false));
+	for (i = 0; i < captureTestFrames; i++) {
+		testFrame(i, frame.data());
+		CHECK(captureFrame(&capture, frame.data()));
+	}
+	CHECK(captureClose(&capture));
+	CHECK(capture.written == captureTestFrames && capture.dropped == 0);
+	std::string y4m = readFile(captureTestPath);
+	std::string header = "YUV4MPEG2 W200 H150 F20:1 Ip A1:1 C420jpeg\n";
+	int frameSize = captureFrameSize(CAPTURE_Y4M);
+	CHECK(frameSize == SW * SH * 3 / 2);
+	CHECK(y4m.size() == header.size() + captureTestFrames * (6 + frameSize));
+	CHECK(y4m.compare(0, header.size(), header) == 0);
+	if (y4m.size() == header.size() + captureTestFrames * (6 + frameSize)) {
+		int mismatches = 0;
+		for (i = 0; i < captureTestFrames; i++) {
+			const unsigned char* data = reinterpret_cast<const unsigned char*>(y4m.data()) + header.size() + i * (6 + frameSize);
+			mismatches += memcmp(data, "FRAME\n", 6) != 0;
+			const unsigned char* planeY = data + 6;
+			const unsigned char* planeU = planeY + SW * SH;
+			const unsigned char* planeV = planeU + SW * SH / 4;
+			// the background is blue, the bottom row yellow and brighter
+			mismatches += planeY[0] != capture.paletteY[8] || planeY[(SH - 1) * SW + 1] != capture.paletteY[0];
+			mismatches += planeY[(SH - 1) * SW] != capture.paletteY[i % 8];
+			mismatches += planeU[0] != capture.paletteU[8] || planeV[0] != capture.paletteV[8];
+			// the chroma of the bottom blocks mixes both colors
+			int mixed = (capture.paletteU[0] * 2 + capture.paletteU[8] * 2 + 2) >> 2;
+			mismatches += planeU[(SH / 2 - 1) * (SW / 2) + 1] != mixed;
+		}
+		CHECK(mismatches == 0);
+	}
+	paletteColor(0, rgb);
+	CHECK(capture.paletteY[0] > capture.paletteY[8] && capture.paletteY[0] <= 235 && capture.paletteY[8] >= 16);
+
+	// raw rgb is just the pixels, top row first
+	CHECK(captureOpen(&capture, captureTestPath, CAPTURE_RGB, false));
+	for (i = 0; i < captureTestFrames; i++) {
+		testFrame(i, frame.data());
+		CHECK(captureFrame(&capture, frame.data()));
+	}
+	CHECK(captureClose(&capture));
+	std::string raw = readFile(captureTestPath);
+	CHECK(raw.size() == static_cast<size_t>(captureTestFrames) * SW * SH * 3);
+	if (raw.size() == static_cast<size_t>(captureTestFrames) * SW * SH * 3) {
+		const unsigned char* last = reinterpret_cast<const unsigned char*>(raw.data()) + (captureTestFrames - 1) * SW * SH * 3;
+		CHECK(memcmp(&last[((SH - 1) * SW + 1) * 3], rgb, 3) == 0);
+		paletteColor(8, rgb);
+		CHECK(memcmp(&last[0], rgb, 3) == 0);
+	}
+	remove(captureTestPath);
+
+	// a capture that cannot open its file takes no frames
+	CHECK(!captureOpen(&capture, "missing_directory/capture.y4m", CAPTURE_Y4M, false));
+	CHECK(!captureFrame(&capture, frame.data()));
+	CHECK(captureClose(&capture));
+
+	printf("capture: %d failures\n", failures);
+	return failures;
+}
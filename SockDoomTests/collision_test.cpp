@@ -0,0 +1,143 @@
+#include "blockmap.h"
+#include "engine.h"
+#include "physics.h"
+#include "tests.h"
+
+// squared distance from x/y to a wall without the blockmap
+static float bruteDistanceSq(const Wall* wall, float x, float y) {
+	float dx = wall->x2 - wall->x1;
+	float dy = wall->y2 - wall->y1;
+	float t = ((x - wall->x1) * dx + (y - wall->y1) * dy) / (dx * dx + dy * dy);
+	t = (t < 0) ? 0 : (t > 1) ? 1 : t;
+	float nearX = wall->x1 + t * dx - x;
+	float nearY = wall->y1 + t * dy - y;
+	return nearX * nearX + nearY * nearY;
+}
+
+static bool bruteTouchesWall(const MapData* map, int x, int y, int radius) {
+	int w;
+
+	for (w = 0; w < map->numWall; w++) {
+		if (bruteDistanceSq(&map->walls[w], x, y) < radius * radius) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool loadBoxGrid(Engine* engine) {
+	static int sectorData[100 * 6];
+	static int wallData[400 * 5];
+	int start[5] = { -50, -50, 20, 45, 0 };
+	int i, j, s = 0, w = 0;
+
+	for (j = 0; j < 10; j++) {
+		for (i = 0; i < 10; i++) {
+			int x = i * 40, y = j * 40;
+			int corners[5][2] = { { x, y }, { x + 24, y }, { x + 24, y + 24 }, { x, y + 24 }, { x, y } };
+			int c;
+			int sector[6] = { w, w + 4, 0, 40, 2, 3 };
+			for (c = 0; c < 6; c++) {
+				sectorData[s * 6 + c] = sector[c];
+			}
+			for (c = 0; c < 4; c++) {
+				int wall[5] = { corners[c][0], corners[c][1], corners[c + 1][0], corners[c + 1][1], c & 1 };
+				int k;
+				for (k = 0; k < 5; k++) {
+					wallData[w * 5 + k] = wall[k];
+				}
+				w++;
+			}
+			s++;
+		}
+	}
+	return loadMapData(engine, sectorData, s, wallData, w, start);
+}
+
+int collisionTests(int argc, char** argv) {
+	int failures = 0;
+	int x, y, i;
+
+	// built-in map, first sector is the box from 0,0 to 32,32
+	Engine* engine = createEngine();
+	CHECK(touchesWall(engine->map.get(), 16, -4, playerRadius, stepHeight, playerHeight));
+	CHECK(!touchesWall(engine->map.get(), 16, -20, playerRadius, stepHeight, playerHeight));
+	CHECK(touchesWall(engine->map.get(), -5, -5, playerRadius, stepHeight, playerHeight));
+	CHECK(!touchesWall(engine->map.get(), 48, 48, playerRadius, stepHeight, playerHeight));
+	// the box is 40 high, so its walls do not block above it
+	CHECK(!touchesWall(engine->map.get(), 16, -4, playerRadius, 40 + stepHeight, 40 + playerHeight));
+
+	// walking straight into a wall stops short of it
+	x = 16;
+	y = -10;
+	slideMove(engine->map.get(), &x, &y, 0, 10, playerRadius, stepHeight, playerHeight);
+	CHECK(x == 16 && y == -10);
+
+	// walking diagonally into it slides along it
+	slideMove(engine->map.get(), &x, &y, 5, 10, playerRadius, stepHeight, playerHeight);
+	CHECK(x == 21 && y == -10);
+
+	// something spawned overlapping the wall cannot push through it, however far it steps
+	int step;
+	for (step = 2; step <= 16; step += 2) {
+		x = 16;
+		y = -4;
+		slideMove(engine->map.get(), &x, &y, 0, step, playerRadius, stepHeight, playerHeight);
+		CHECK(y <= -4);
+		slideMove(engine->map.get(), &x, &y, 3, step, playerRadius, stepHeight, playerHeight);
+		CHECK(y <= -4);
+	}
+	// but it can slide along it and back out
+	slideMove(engine->map.get(), &x, &y, 3, 0, playerRadius, stepHeight, playerHeight);
+	CHECK(x == 22 && y == -4);
+	slideMove(engine->map.get(), &x, &y, 0, -3, playerRadius, stepHeight, playerHeight);
+	CHECK(x == 22 && y == -7);
+
+	// open space moves freely
+	x = 48;
+	y = -40;
+	slideMove(engine->map.get(), &x, &y, 7, -9, playerRadius, stepHeight, playerHeight);
+	CHECK(x == 55 && y == -49);
+
+	// the blockmap finds exactly the walls a test against every wall finds
+	CHECK(loadBoxGrid(engine));
+	CHECK(engine->map->blockmap.width * engine->map->blockmap.height > 1);
+	int mismatches = 0;
+	for (y = -30; y < 420; y += 3) {
+		for (x = -30; x < 420; x += 3) {
+			if (touchesWall(engine->map.get(), x, y, playerRadius, stepHeight, playerHeight) != bruteTouchesWall(engine->map.get(), x, y, playerRadius)) {
+				mismatches++;
+			}
+		}
+	}
+	CHECK(mismatches == 0);
+
+	// boxes so far apart that their extent does not fit in an int still get a grid that covers them
+	static int farSectors[2 * 6] = { 0, 4, 0, 40, 2, 3, 4, 8, 0, 40, 2, 3 };
+	static int farWalls[8 * 5];
+	int farStart[5] = { -1100000000 + 12, -1100000000 + 12, 20, 0, 0 };
+	int farCorners[2] = { -1100000000, 1100000000 };
+	for (i = 0; i < 2; i++) {
+		int c = farCorners[i];
+		int box[5][2] = { { c, c }, { c + 256, c }, { c + 256, c + 256 }, { c, c + 256 }, { c, c } };
+		int k;
+		for (k = 0; k < 4; k++) {
+			int wall[5] = { box[k][0], box[k][1], box[k + 1][0], box[k + 1][1], k & 1 };
+			int f;
+			for (f = 0; f < 5; f++) {
+				farWalls[(i * 4 + k) * 5 + f] = wall[f];
+			}
+		}
+	}
+	CHECK(loadMapData(engine, farSectors, 2, farWalls, 8, farStart));
+	const Blockmap* blockmap = &engine->map->blockmap;
+	CHECK(blockmap->width > 0 && blockmap->height > 0 && blockmap->width * blockmap->height <= maxBlocks);
+	CHECK(static_cast<long long>(blockmap->width) * blockmap->size > 2200000256LL);
+	CHECK(touchesWall(engine->map.get(), -1100000000, -1100000000, playerRadius, stepHeight, playerHeight));
+	CHECK(touchesWall(engine->map.get(), 1100000256, 1100000256, playerRadius, stepHeight, playerHeight));
+	CHECK(!touchesWall(engine->map.get(), 0, 0, playerRadius, stepHeight, playerHeight));
+
+	destroyEngine(engine);
+	printf("collision: %d failures\n", failures);
+	return failures;
+}
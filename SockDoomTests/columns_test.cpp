@@ -0,0 +1,116 @@
+#include <cstring>
+#include <vector>
+#include "detail.h"
+#include "engine.h"
+#include "render.h"
+#include "tests.h"
+
+// inside the box grid looking across it, and a step to the side
+static Player columnCamera(int side) {
+	Player camera = Player();
+
+	camera.x = 100 + side * 15;
+	camera.y = -40;
+	camera.z = 20;
+	camera.angle = 20;
+	return camera;
+}
+
+// draw one frame from the camera without settling the sector order
+static void drawFrame(Engine* engine, const Player* camera) {
+	resetRenderStats(&engine->view.renderStats);
+	clearBackground(&engine->view);
+	draw3D(engine, camera);
+	arenaReset(&engine->view.frameArena);
+}
+
+// full detail frame from the first camera, then one from the second; both from a fresh sector order
+static void drawPair(Engine* engine, unsigned char* first, unsigned char* second) {
+	Player camera = columnCamera(0);
+
+	resetSectorOrder(&engine->view, engine->map->numSect);
+	engine->player = camera;
+	renderStill(engine);
+	memcpy(first, engine->view.frameBuffer, SW * SH);
+	camera = columnCamera(1);
+	drawFrame(engine, &camera);
+	memcpy(second, engine->view.frameBuffer, SW * SH);
+}
+
+int columnTests(int argc, char** argv) {
+	int failures = 0;
+	int x, y, i;
+	Engine* engine = createEngine();
+	std::vector<unsigned char> full(SW * SH), fullNext(SW * SH), frame(SW * SH);
+	std::vector<float> depth(SW * SH);
+	DetailControl control;
+
+	CHECK(loadBoxGrid(engine));
+	drawPair(engine, full.data(), fullNext.data());
+	CHECK(memcmp(full.data(), fullNext.data(), SW * SH) != 0);
+
+	// low detail draws the odd columns as they are at full detail and doubles them
+	engine->view.columnMode = COLUMNS_LOW;
+	engine->view.depthBuffer = depth.data();
+	drawPair(engine, frame.data(), frame.data());
+	int mismatches = 0, doubled = 0;
+	for (y = 0; y < SH; y++) {
+		for (x = 1; x + 1 < SW; x += 2) {
+			mismatches += frame[y * SW + x] != fullNext[y * SW + x];
+			doubled += frame[y * SW + x + 1] != frame[y * SW + x] || depth[y * SW + x + 1] != depth[y * SW + x];
+		}
+	}
+	CHECK(mismatches == 0 && doubled == 0);
+	CHECK(memcmp(frame.data(), fullNext.data(), SW * SH) != 0);
+	engine->view.depthBuffer = nullptr;
+
+	// and so does a batch of views
+	View* view = createView();
+	Player camera = columnCamera(1);
+	view->columnMode = COLUMNS_LOW;
+	drawViews(engine, &camera, &view, 1);
+	resetSectorOrder(&engine->view, engine->map->numSect);
+	engine->player = camera;
+	renderStill(engine);
+	CHECK(memcmp(view->frameBuffer, engine->view.frameBuffer, SW * SH) == 0);
+	destroyView(view);
+
+	// a still is drawn whole when interlaced, after that each frame draws half the columns and keeps
+	// the other half from the last one
+	engine->view.columnMode = COLUMNS_INTERLACED;
+	resetSectorOrder(&engine->view, engine->map->numSect);
+	engine->player = columnCamera(0);
+	renderStill(engine);
+	CHECK(memcmp(engine->view.frameBuffer, full.data(), SW * SH) == 0);
+	int parity = engine->view.columnParity;
+	camera = columnCamera(1);
+	drawFrame(engine, &camera);
+	mismatches = 0;
+	for (i = 0; i < SW * SH; i++) {
+		mismatches += engine->view.frameBuffer[i] != ((i % SW % 2 == parity) ? fullNext[i] : full[i]);
+	}
+	CHECK(mismatches == 0);
+	CHECK(engine->view.columnParity != parity);
+	// the next frame from the same camera fills in the rest
+	drawFrame(engine, &camera);
+	CHECK(memcmp(engine->view.frameBuffer, fullNext.data(), SW * SH) == 0);
+
+	// the controller drops detail over budget and only comes back well under it
+	detailInit(&control, 1000, COLUMNS_LOW);
+	for (i = 0; i < detailFrames - 1; i++) {
+		CHECK(detailUpdate(&control, 950) == COLUMNS_FULL);
+	}
+	CHECK(detailUpdate(&control, 950) == COLUMNS_LOW);
+	for (i = 0; i < detailFrames; i++) {
+		CHECK(detailUpdate(&control, 500) == COLUMNS_LOW);
+	}
+	for (i = 0; i < detailFrames; i++) {
+		detailUpdate(&control, 300);
+	}
+	CHECK(control.columns == COLUMNS_FULL);
+
+	destroyEngine(engine);
+
+	printf("columns: %d failures\n", failures);
+	return failures;
+}
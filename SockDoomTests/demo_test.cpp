@@ -0,0 +1,158 @@
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "demo.h"
+#include "engine.h"
+#include "pipeline.h"
+#include "render.h"
+#include "tests.h"
+
+// defines for demo test settings
+#define demoTestTicks      120                     // length of the scripted session
+#define demoTestFile       "sockdoom_test.dem"     // written to the working directory and removed
+#define demoTestEngines    8                       // engines playing the demo at once
+
+// keys of the scripted session: walk, turn, strafe, jump, fly up and come back down, then stand still
+static Keys demoScript(int tick) {
+	Keys input = Keys();
+
+	input.w = tick < 90 && (tick / 15) % 3 != 2;
+	input.d = (tick / 20) % 2;
+	input.strafeL = tick >= 40 && tick < 50;
+	input.jump = tick == 25 || tick == 60;
+	input.fly = tick >= 70 && tick < 80;
+	input.mlook = input.fly;
+	return input;
+}
+
+// fnv-1a hash of the frame buffer
+static unsigned int hashFrameBuffer(const Engine* engine) {
+	unsigned int hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < SW * SH; i++) {
+		hash = (hash ^ engine->view.frameBuffer[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static void renderFrame(Engine* engine) {
+	resetRenderStats(&engine->view.renderStats);
+	clearBackground(&engine->view);
+	draw3D(engine, &engine->player);
+	arenaReset(&engine->view.frameArena);
+}
+
+// play a demo on an engine, rendering every tick, and sum the hashes of the frames
+static void playDemo(Engine* engine, const Demo* demo, unsigned int* frameSum) {
+	int t;
+
+	*frameSum = 0;
+	for (t = 0; t < demo->numTicks; t++) {
+		renderFrame(engine);
+		*frameSum += hashFrameBuffer(engine);
+		demoTick(engine, demo, t);
+	}
+}
+
+int demoTests(int argc, char** argv) {
+	static Demo recorded, loaded;
+	static Pipeline pipeline;
+	int failures = 0;
+	int t, mask;
+	std::vector<unsigned int> frames(demoTestTicks);
+
+	// every key combination survives packing
+	int wrong = 0;
+	for (mask = 0; mask < 512; mask++) {
+		Keys unpacked;
+		unpackKeys(static_cast<unsigned short>(mask), &unpacked);
+		wrong += packKeys(&unpacked) != mask;
+	}
+	CHECK(wrong == 0);
+
+	// record the scripted session, keeping the frame of every tick
+	Engine* engine = createEngine();
+	CHECK(demoBegin(&recorded, engine, nullptr));
+	unsigned int frameSum = 0;
+	for (t = 0; t < demoTestTicks; t++) {
+		renderFrame(engine);
+		frames[t] = hashFrameBuffer(engine);
+		frameSum += frames[t];
+		engine->keys = demoScript(t);
+		CHECK(demoRecordTick(&recorded, &engine->keys));
+		movePlayer(engine);
+	}
+	Player end = engine->player;
+	CHECK(end.x != recorded.start[0] || end.y != recorded.start[1]);
+
+	// the file reads back the same
+	CHECK(demoWrite(&recorded, demoTestFile));
+	CHECK(demoRead(&loaded, demoTestFile));
+	CHECK(strcmp(loaded.map, recorded.map) == 0 && loaded.numTicks == demoTestTicks);
+	CHECK(memcmp(loaded.start, recorded.start, sizeof(loaded.start)) == 0);
+	CHECK(memcmp(loaded.ticks, recorded.ticks, demoTestTicks * sizeof(loaded.ticks[0])) == 0);
+
+	// playback draws the same frames and ends in the same place
+	CHECK(demoStart(engine, &loaded));
+	int mismatches = 0;
+	for (t = 0; t < loaded.numTicks; t++) {
+		renderFrame(engine);
+		mismatches += hashFrameBuffer(engine) != frames[t];
+		demoTick(engine, &loaded, t);
+	}
+	CHECK(mismatches == 0);
+	CHECK(engine->player.x == end.x && engine->player.y == end.y && engine->player.z == end.z && engine->player.angle == end.angle);
+
+	// and so does playback on several engines at once, each on its own thread
+	Engine* engines[demoTestEngines];
+	unsigned int sums[demoTestEngines];
+	std::vector<std::thread> threads;
+	for (t = 0; t < demoTestEngines; t++) {
+		engines[t] = createEngine();
+		CHECK(demoStart(engines[t], &loaded));
+		threads.push_back(std::thread(playDemo, engines[t], &loaded, &sums[t]));
+	}
+	mismatches = 0;
+	for (t = 0; t < demoTestEngines; t++) {
+		threads[t].join();
+		const Player* player = &engines[t]->player;
+		mismatches += sums[t] != frameSum;
+		mismatches += player->x != end.x || player->y != end.y || player->z != end.z || player->angle != end.angle;
+		// the built-in map is shared rather than copied
+		mismatches += engines[t]->map != engine->map;
+		destroyEngine(engines[t]);
+	}
+	CHECK(mismatches == 0);
+
+	// and so does playback through the pipeline
+	CHECK(demoStart(engine, &loaded));
+	pipelineInit(&pipeline);
+	pipelineDemo(&pipeline, nullptr, &loaded);
+	pipelineStart(&pipeline, engine);
+	for (;;) {
+		pipelineWait(&pipeline);
+		if (pipelineDemoDone(&pipeline)) {
+			break;
+		}
+		pipelineKick(&pipeline, 0, RENDER_NORMAL, COLUMNS_FULL);
+	}
+	pipelineStop(&pipeline);
+	CHECK(engine->player.x == end.x && engine->player.y == end.y && engine->player.z == end.z && engine->player.angle == end.angle);
+
+	// a cut short file is refused
+	FILE* file = fopen(demoTestFile, "wb");
+	CHECK(file != nullptr);
+	if (file != nullptr) {
+		fwrite("SDDM\x01", 1, 5, file);
+		fclose(file);
+		CHECK(!demoRead(&loaded, demoTestFile));
+	}
+	remove(demoTestFile);
+
+	destroyEngine(engine);
+
+	printf("demo: %d failures\n", failures);
+	return failures;
+}
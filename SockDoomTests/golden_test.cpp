@@ -0,0 +1,147 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include "engine.h"
+#include "render.h"
+#include "tests.h"
+
+// defines for test settings
+#ifndef SOCKDOOM_GOLDEN_DIR
+#define SOCKDOOM_GOLDEN_DIR "golden"                // default golden image directory, set by the build
+#endif
+#define goldenTolerance    (SW*SH/200)             // pixels allowed to differ from a golden image (0.5%)
+#define timingRuns         50                      // frames rendered per pose to time it
+
+struct Pose {
+	// name of the golden image
+	const char* name;
+	// x, y, z, angle, look
+	int pose[5];
+};
+
+// camera poses covering culling, clipping behind the player and both surface types
+Pose poses[] = {
+	{ "start",          {  70, -110,  20,   0,   0 } },
+	{ "diagonal",       {  48,  -60,  20,  10,   0 } },
+	{ "corner",         { -40,  -40,  20,  45,   0 } },
+	{ "between",        {  48,   48,  20,  90,   0 } },
+	{ "above",          {  48, -150,  60,   0,  12 } },
+	{ "below",          {  48, -120, -10,   0,  -8 } },
+	{ "close_clip",     {  36,   -8,  20, 330,   0 } },
+	{ "behind",         {  48,  160,  20, 180,   0 } },
+};
+
+#define numPoses           (int)(sizeof(poses) / sizeof(poses[0]))
+
+// read a binary ppm of the screen size into rgb
+bool readPPM(const char* path, unsigned char* rgb) {
+	int width, height, maxValue;
+	FILE* file = fopen(path, "rb");
+	if (file == nullptr) {
+		return false;
+	}
+
+	bool ok = fscanf(file, "P6 %d %d %d", &width, &height, &maxValue) == 3 && width == SW && height == SH && maxValue == 255;
+	// single whitespace byte after the header
+	ok = ok && fgetc(file) != EOF;
+	ok = ok && fread(rgb, 1, SW * SH * 3, file) == static_cast<size_t>(SW * SH * 3);
+
+	fclose(file);
+	return ok;
+}
+
+// expand the frame buffer into rgb rows, top row first like the ppm
+void frameToRGB(const Engine* engine, unsigned char* rgb) {
+	int x, y;
+
+	for (y = SH - 1; y >= 0; y--) {
+		for (x = 0; x < SW; x++) {
+			paletteColor(engine->view.frameBuffer[y * SW + x], rgb);
+			rgb += 3;
+		}
+	}
+}
+
+// 64-bit fnv-1a hash
+unsigned long long hashBytes(const unsigned char* data, int size) {
+	unsigned long long hash = 14695981039346656037ull;
+	int i;
+
+	for (i = 0; i < size; i++) {
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+// render every pose and compare it to its golden image in the directory given as the first argument,
+// --update rewrites the golden images instead
+int goldenTests(int argc, char** argv) {
+	const char* goldenDir = SOCKDOOM_GOLDEN_DIR;
+	bool update = false;
+	int i, p, failures = 0;
+	static unsigned char actual[SW * SH * 3];
+	static unsigned char expected[SW * SH * 3];
+	char path[512];
+
+	for (i = 0; i < argc; i++) {
+		if (strcmp(argv[i], "--update") == 0) {
+			update = true;
+		}
+		else {
+			goldenDir = argv[i];
+		}
+	}
+
+	Engine* engine = createEngine();
+	for (p = 0; p < numPoses; p++) {
+		init(engine);
+		setPose(engine, poses[p].pose);
+		renderStill(engine);
+		frameToRGB(engine, actual);
+		snprintf(path, sizeof(path), "%s/%s.ppm", goldenDir, poses[p].name);
+
+		// time the pose once the sector order has settled
+		auto start = std::chrono::steady_clock::now();
+		for (i = 0; i < timingRuns; i++) {
+			clearBackground(&engine->view);
+			draw3D(engine, &engine->player);
+			arenaReset(&engine->view.frameArena);
+		}
+		double micros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / timingRuns;
+
+		if (update) {
+			if (!writeFramebufferPPM(&engine->view, path)) {
+				std::cout << "FAIL " << poses[p].name << ": could not write " << path << std::endl;
+				failures++;
+				continue;
+			}
+			std::cout << "updated " << poses[p].name << std::endl;
+			continue;
+		}
+
+		if (!readPPM(path, expected)) {
+			std::cout << "FAIL " << poses[p].name << ": could not read " << path << std::endl;
+			failures++;
+			continue;
+		}
+
+		int differing = 0;
+		for (i = 0; i < SW * SH; i++) {
+			if (memcmp(&actual[i * 3], &expected[i * 3], 3) != 0) {
+				differing++;
+			}
+		}
+
+		bool pass = differing <= goldenTolerance;
+		if (!pass) {
+			failures++;
+		}
+		printf("%s %-12s hash %016llx  %5d pixels differ  %8.1f us/frame\n", pass ? "ok  " : "FAIL", poses[p].name,
+			hashBytes(actual, SW * SH * 3), differing, micros);
+	}
+
+	destroyEngine(engine);
+	return failures;
+}
@@ -0,0 +1,102 @@
+#include <thread>
+#include "input.h"
+#include "tests.h"
+
+// defines for input test settings
+#define stressEvents       200000                  // events passed between threads by the stress test
+
+int inputTests(int argc, char** argv) {
+	static InputQueue queue;
+	int failures = 0;
+	int i;
+	InputEvent event;
+	Keys held = Keys(), tick = Keys();
+	int64_t firstTime;
+
+	// events come out in order with increasing times
+	inputClear(&queue);
+	CHECK(!inputPop(&queue, &event));
+	CHECK(inputPush(&queue, INPUT_W, 1));
+	CHECK(inputPush(&queue, INPUT_D, 0));
+	CHECK(inputPop(&queue, &event) && event.key == INPUT_W && event.pressed == 1);
+	int64_t firstPush = event.time;
+	CHECK(inputPop(&queue, &event) && event.key == INPUT_D && event.pressed == 0 && event.time >= firstPush);
+	CHECK(!inputPop(&queue, &event));
+
+	// a full queue drops events instead of overwriting them
+	for (i = 0; i < inputQueueSize; i++) {
+		inputPush(&queue, INPUT_A, i & 1);
+	}
+	CHECK(!inputPush(&queue, INPUT_A, 1));
+	CHECK(queue.dropped == 1);
+	inputClear(&queue);
+
+	// a held key stays down over ticks with no events
+	inputPush(&queue, INPUT_W, 1);
+	inputTick(&queue, &held, &tick, &firstTime);
+	CHECK(tick.w == 1 && held.w == 1 && firstTime != 0);
+	inputTick(&queue, &held, &tick, &firstTime);
+	CHECK(tick.w == 1 && firstTime == 0);
+
+	// a tap between two ticks counts for one tick
+	inputPush(&queue, INPUT_JUMP, 1);
+	inputPush(&queue, INPUT_JUMP, 0);
+	inputTick(&queue, &held, &tick, &firstTime);
+	CHECK(tick.jump == 1 && held.jump == 0);
+	inputTick(&queue, &held, &tick, &firstTime);
+	CHECK(tick.jump == 0);
+
+	// a release lets the key go
+	inputPush(&queue, INPUT_W, 0);
+	inputTick(&queue, &held, &tick, &firstTime);
+	CHECK(tick.w == 0 && held.w == 0);
+
+	// fly flips on presses only
+	inputPush(&queue, INPUT_FLY, 1);
+	inputPush(&queue, INPUT_FLY, 0);
+	inputTick(&queue, &held, &tick, &firstTime);
+	CHECK(tick.fly == 1 && held.fly == 1);
+	inputPush(&queue, INPUT_FLY, 1);
+	inputTick(&queue, &held, &tick, &firstTime);
+	CHECK(tick.fly == 0 && held.fly == 0);
+
+	// one thread pushing while another pops sees every event once and in order
+	inputClear(&queue);
+	std::thread producer([] {
+		int e = 0;
+		while (e < stressEvents) {
+			if (inputPush(&queue, e % INPUT_COUNT, (e / INPUT_COUNT) & 1)) {
+				e++;
+			}
+			else {
+				std::this_thread::yield();
+			}
+		}
+	});
+	int received = 0, wrong = 0;
+	while (received < stressEvents) {
+		if (inputPop(&queue, &event)) {
+			wrong += event.key != received % INPUT_COUNT || event.pressed != ((received / INPUT_COUNT) & 1);
+			received++;
+		}
+		else {
+			std::this_thread::yield();
+		}
+	}
+	producer.join();
+	CHECK(wrong == 0);
+	CHECK(!inputPop(&queue, &event));
+	inputClear(&queue);
+
+	// latency keeps a running average of recent frames and the worst one
+	InputLatency latency = InputLatency();
+	CHECK(latencyAverage(&latency) == 0);
+	for (i = 0; i < latencySamples * 2; i++) {
+		latencyRecord(&latency, (i < latencySamples) ? 1000 : 3000);
+	}
+	latencyRecord(&latency, 3000);
+	CHECK(latencyAverage(&latency) == 3000 && latency.worst == 3000);
+
+	printf("input: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,165 @@
+#include <thread>
+#include <vector>
+#include "actor.h"
+#include "engine.h"
+#include "jobs.h"
+#include "tests.h"
+
+// items of the parallel for tests, each counts how often it was visited
+static std::vector<int> visits;
+
+static void visitRange(int begin, int end, void* data) {
+	int i;
+
+	for (i = begin; i < end; i++) {
+		visits[i]++;
+	}
+}
+
+// counts visits to the items of an inner parallel for
+static void innerRange(int begin, int end, void* data) {
+	int* items = static_cast<int*>(data);
+	int i;
+
+	for (i = begin; i < end; i++) {
+		items[i]++;
+	}
+}
+
+// each outer item runs a parallel for over 8 items of its own
+static void nestedRange(int begin, int end, void* data) {
+	int* items = static_cast<int*>(data);
+	int i;
+
+	for (i = begin; i < end; i++) {
+		parallelFor(8, 1, innerRange, &items[i * 8]);
+	}
+}
+
+// a thread that is not a worker running parallel fors, and the tag of the thread that ran each item
+struct Submitter {
+	int tag;
+	std::vector<int> ranBy;
+	// items run by the other submitter
+	int foreign;
+};
+
+// tag of the submitter running on this thread, 0 for workers
+static thread_local int submitTag = 0;
+
+static void recordRange(int begin, int end, void* data) {
+	Submitter* submitter = static_cast<Submitter*>(data);
+	int i;
+
+	for (i = begin; i < end; i++) {
+		submitter->ranBy[i] = submitTag;
+	}
+	// give the other submitter a chance to run while this one's items are still queued
+	std::this_thread::yield();
+}
+
+static void submitLoop(Submitter* submitter) {
+	int round, i;
+
+	submitTag = submitter->tag;
+	submitter->foreign = 0;
+	for (round = 0; round < 200; round++) {
+		parallelFor(static_cast<int>(submitter->ranBy.size()), 1, recordRange, submitter);
+		for (i = 0; i < static_cast<int>(submitter->ranBy.size()); i++) {
+			submitter->foreign += submitter->ranBy[i] != 0 && submitter->ranBy[i] != submitter->tag;
+		}
+	}
+}
+
+// run a crowd for some ticks and return a checksum of every actor's state
+static unsigned int runCrowd(int threads) {
+	unsigned int sum = 0;
+	int i, t;
+
+	jobsInit(threads);
+	Engine* engine = createEngine();
+	for (i = 0; i < 3000; i++) {
+		spawnActor(engine, -300 + (i % 60) * 10, -300 + (i / 60) * 10, i * 13);
+	}
+	int pose[5] = { 48, 48, 20, 0, 0 };
+	setPose(engine, pose);
+	for (t = 0; t < 60; t++) {
+		thinkActors(engine);
+		moveActors(engine);
+	}
+	const Actors* actors = &engine->actors;
+	for (i = 0; i < actors->count; i++) {
+		sum = sum * 31u + actors->x[i];
+		sum = sum * 31u + actors->y[i];
+		sum = sum * 31u + actors->z[i];
+		sum = sum * 31u + actors->angle[i];
+		sum = sum * 31u + actors->state[i];
+		sum = sum * 31u + actors->sector[i];
+	}
+	destroyEngine(engine);
+	return sum;
+}
+
+int jobsTests(int argc, char** argv) {
+	int failures = 0;
+	int threads, i;
+
+	for (threads = 1; threads <= 4; threads *= 2) {
+		jobsInit(threads);
+		CHECK(jobThreads() == threads && jobThread() == 0);
+
+		// every item is visited exactly once, including a short last range
+		visits.assign(100003, 0);
+		parallelFor(static_cast<int>(visits.size()), 100, visitRange, nullptr);
+		int wrong = 0;
+		for (i = 0; i < static_cast<int>(visits.size()); i++) {
+			wrong += visits[i] != 1;
+		}
+		CHECK(wrong == 0);
+
+		// more ranges than fit in a queue
+		visits.assign(5000, 0);
+		parallelFor(5000, 1, visitRange, nullptr);
+		wrong = 0;
+		for (i = 0; i < 5000; i++) {
+			wrong += visits[i] != 1;
+		}
+		CHECK(wrong == 0);
+
+		// parallel fors started from inside jobs
+		std::vector<int> inner(64 * 8, 0);
+		parallelFor(64, 4, nestedRange, inner.data());
+		wrong = 0;
+		for (i = 0; i < 64 * 8; i++) {
+			wrong += inner[i] != 1;
+		}
+		CHECK(wrong == 0);
+
+		// nothing to do
+		parallelFor(0, 10, visitRange, nullptr);
+	}
+
+	// threads that are not workers each queue into their own deque and never run each other's items
+	jobsInit(2);
+	Submitter first, second;
+	first.tag = 1;
+	second.tag = 2;
+	first.ranBy.assign(64, 0);
+	second.ranBy.assign(64, 0);
+	std::thread firstThread(submitLoop, &first);
+	std::thread secondThread(submitLoop, &second);
+	firstThread.join();
+	secondThread.join();
+	CHECK(first.foreign == 0 && second.foreign == 0);
+
+	// actors end up the same on any number of threads
+	unsigned int single = runCrowd(1);
+	CHECK(runCrowd(2) == single);
+	CHECK(runCrowd(4) == single);
+
+	jobsShutdown();
+	CHECK(jobThreads() == 1);
+
+	printf("jobs: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,105 @@
+#include "engine.h"
+#include "physics.h"
+#include "tests.h"
+
+// three 32x32 boxes in a row along x: a low step, a tall wall and a floating block
+static bool loadStepMap(Engine* engine) {
+	static int sectorData[3 * 6] = {
+		// wall start, wall end, z1, z2, bottom color, top color
+		0,  4,  0, 10, 2, 3,
+		4,  8,  0, 40, 4, 5,
+		8, 12, 36, 60, 6, 7,
+	};
+	static int wallData[12 * 5];
+	int start[5] = { -50, -50, 20, 0, 0 };
+	int b, c, k;
+
+	for (b = 0; b < 3; b++) {
+		int x = b * 64;
+		int corners[5][2] = { { x, 0 }, { x + 32, 0 }, { x + 32, 32 }, { x, 32 }, { x, 0 } };
+		for (c = 0; c < 4; c++) {
+			int wall[5] = { corners[c][0], corners[c][1], corners[c + 1][0], corners[c + 1][1], c & 1 };
+			for (k = 0; k < 5; k++) {
+				wallData[(b * 4 + c) * 5 + k] = wall[k];
+			}
+		}
+	}
+	return loadMapData(engine, sectorData, 3, wallData, 12, start);
+}
+
+// place the player on the ground facing +y and walk forward for some ticks
+static void walkForward(Engine* engine, int x, int y, int ticks) {
+	int pose[5] = { x, y, eyeHeight, 0, 0 };
+	int t;
+
+	setPose(engine, pose);
+	engine->keys = Keys();
+	engine->keys.w = 1;
+	for (t = 0; t < ticks; t++) {
+		movePlayer(engine);
+	}
+	engine->keys = Keys();
+}
+
+int physicsTests(int argc, char** argv) {
+	int failures = 0;
+	int t;
+
+	// falling from high up lands on open ground
+	int z = 100, velZ = 0;
+	for (t = 0; t < 40; t++) {
+		fallMove(&z, &velZ, groundHeight, noCeiling, playerHeight);
+	}
+	CHECK(z == groundHeight && velZ == 0);
+
+	// sector spans: on top of, or under a sector
+	Engine* engine = createEngine();
+	CHECK(loadStepMap(engine));
+	int floor, ceiling;
+	sectorSpan(engine->map.get(), 0, 0, &floor, &ceiling);
+	CHECK(floor == 10 && ceiling == noCeiling);
+	sectorSpan(engine->map.get(), 2, 0, &floor, &ceiling);
+	CHECK(floor == groundHeight && ceiling == 36);
+	sectorSpan(engine->map.get(), -1, 0, &floor, &ceiling);
+	CHECK(floor == groundHeight && ceiling == noCeiling);
+
+	// a low step is walked onto
+	walkForward(engine, 16, -20, 5);
+	CHECK(engine->player.y > 0 && engine->player.sector == 0);
+	CHECK(engine->player.z == 10 + eyeHeight);
+
+	// a tall sector blocks
+	walkForward(engine, 80, -20, 5);
+	CHECK(engine->player.y < 0 && engine->player.z == eyeHeight);
+
+	// a floating block is walked under, and a jump beneath it bumps its bottom
+	walkForward(engine, 144, -20, 5);
+	CHECK(engine->player.y > 0 && engine->player.sector == 2 && engine->player.z == eyeHeight);
+	engine->keys.jump = 1;
+	int highest = engine->player.z;
+	for (t = 0; t < 10; t++) {
+		movePlayer(engine);
+		if (engine->player.z > highest) {
+			highest = engine->player.z;
+		}
+	}
+	engine->keys = Keys();
+	CHECK(highest == 36 - playerHeight + eyeHeight);
+
+	// a jump on open ground comes back down to the same height
+	int pose[5] = { -50, -50, eyeHeight, 0, 0 };
+	setPose(engine, pose);
+	engine->keys.jump = 1;
+	movePlayer(engine);
+	engine->keys = Keys();
+	CHECK(engine->player.z > eyeHeight);
+	for (t = 0; t < 30; t++) {
+		movePlayer(engine);
+	}
+	CHECK(engine->player.z == eyeHeight && engine->player.velZ == 0);
+
+	destroyEngine(engine);
+
+	printf("physics: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,149 @@
+#include <vector>
+#include "actor.h"
+#include "engine.h"
+#include "input.h"
+#include "pipeline.h"
+#include "render.h"
+#include "tests.h"
+#include "triplebuffer.h"
+
+// defines for pipeline test settings
+#define pipelineTicks      60                      // ticks run through both the serial and pipelined loops
+
+// keys held on a tick: walk forward, turning now and then, with a jump in the middle
+static Keys scriptKeys(int tick) {
+	Keys input = Keys();
+
+	input.w = 1;
+	input.a = (tick / 10) % 2;
+	input.jump = tick == 30;
+	return input;
+}
+
+// queue the presses and releases that turn the keys held on one tick into those of the next
+static void pushKeyChanges(InputQueue* queue, const Keys* from, const Keys* to) {
+	if (from->w != to->w) {
+		inputPush(queue, INPUT_W, to->w);
+	}
+	if (from->a != to->a) {
+		inputPush(queue, INPUT_A, to->a);
+	}
+	if (from->jump != to->jump) {
+		inputPush(queue, INPUT_JUMP, to->jump);
+	}
+}
+
+// fnv-1a hash of a frame
+static unsigned int hashFrame(const unsigned char* frame) {
+	unsigned int hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < SW * SH; i++) {
+		hash = (hash ^ frame[i]) * 16777619u;
+	}
+	return hash;
+}
+
+// map with a few actors near the start
+static void loadPipelineScene(Engine* engine) {
+	int i;
+
+	init(engine);
+	for (i = 0; i < 50; i++) {
+		spawnActor(engine, 40 + (i % 10) * 8, -120 + (i / 10) * 8, i * 30);
+	}
+}
+
+int pipelineTests(int argc, char** argv) {
+	static TripleBuffer presented;
+	static Pipeline pipeline, second;
+	int failures = 0;
+	int t;
+	std::vector<unsigned int> serial(pipelineTicks);
+
+	// render a tick's state, then simulate the next tick, one after the other
+	Engine* engine = createEngine();
+	loadPipelineScene(engine);
+	for (t = 0; t < pipelineTicks; t++) {
+		resetRenderStats(&engine->view.renderStats);
+		clearBackground(&engine->view);
+		draw3D(engine, &engine->player);
+		arenaReset(&engine->view.frameArena);
+		serial[t] = hashFrame(engine->view.frameBuffer);
+
+		engine->keys = scriptKeys(t);
+		movePlayer(engine);
+		thinkActors(engine);
+		moveActors(engine);
+	}
+	int serialX = engine->player.x, serialY = engine->player.y, serialZ = engine->player.z;
+
+	// the same ticks with rendering and simulation on their own threads
+	loadPipelineScene(engine);
+	tripleInit(&presented);
+	pipelineInit(&pipeline);
+	pipelinePresent(&pipeline, &presented);
+	pipelineStart(&pipeline, engine);
+	int mismatches = 0;
+	int presentMismatches = 0;
+	Keys last = Keys();
+	for (t = 0; t < pipelineTicks; t++) {
+		pipelineWait(&pipeline);
+		if (t > 0) {
+			mismatches += hashFrame(pipelineFrame(&pipeline)) != serial[t - 1];
+			mismatches += pipelineFrameState(&pipeline)->tick != t - 1;
+			// the present thread gets each frame as it is finished
+			presentMismatches += !tripleTake(&presented) || hashFrame(tripleFront(&presented)) != serial[t - 1];
+		}
+		// the keys reach the simulation as events
+		Keys input = scriptKeys(t);
+		pushKeyChanges(&pipeline.input, &last, &input);
+		last = input;
+		pipelineKick(&pipeline, 0, RENDER_NORMAL, COLUMNS_FULL);
+	}
+	pipelineWait(&pipeline);
+	mismatches += hashFrame(pipelineFrame(&pipeline)) != serial[pipelineTicks - 1];
+	pipelineStop(&pipeline);
+	CHECK(mismatches == 0);
+	CHECK(presentMismatches == 0 && presented.dropped == 0);
+	CHECK(engine->player.x == serialX && engine->player.y == serialY && engine->player.z == serialZ);
+
+	// the frames are not all the same, so the comparison means something
+	CHECK(serial[0] != serial[pipelineTicks - 1]);
+
+	// two pipelines run side by side, each on its own engine and input queue
+	Engine* other = createEngine();
+	loadPipelineScene(engine);
+	loadPipelineScene(other);
+	pipelineInit(&pipeline);
+	pipelineInit(&second);
+	pipelineStart(&pipeline, engine);
+	pipelineStart(&second, other);
+	mismatches = 0;
+	last = Keys();
+	for (t = 0; t < pipelineTicks; t++) {
+		pipelineWait(&pipeline);
+		pipelineWait(&second);
+		if (t > 0) {
+			mismatches += hashFrame(pipelineFrame(&pipeline)) != serial[t - 1];
+			mismatches += hashFrame(pipelineFrame(&second)) != serial[t - 1];
+		}
+		Keys input = scriptKeys(t);
+		pushKeyChanges(&pipeline.input, &last, &input);
+		pushKeyChanges(&second.input, &last, &input);
+		last = input;
+		pipelineKick(&pipeline, 0, RENDER_NORMAL, COLUMNS_FULL);
+		pipelineKick(&second, 0, RENDER_NORMAL, COLUMNS_FULL);
+	}
+	pipelineStop(&pipeline);
+	pipelineStop(&second);
+	CHECK(mismatches == 0);
+	CHECK(engine->player.x == serialX && engine->player.y == serialY && engine->player.z == serialZ);
+	CHECK(other->player.x == serialX && other->player.y == serialY && other->player.z == serialZ);
+
+	destroyEngine(other);
+	destroyEngine(engine);
+
+	printf("pipeline: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,86 @@
+#include <thread>
+#include "jobs.h"
+#include "profiler.h"
+#include "tests.h"
+
+// defines for profiler test settings
+#define profileTestThreads 4                       // threads recording into one frame
+#define profileTestEvents  50                      // events each of them records
+
+static void recordEvents(int thread) {
+	int e;
+
+	profileSetThread(thread);
+	for (e = 0; e < profileTestEvents; e++) {
+		profileRecord(STAGE_RASTER, 0, 10);
+	}
+}
+
+static void recordRange(int begin, int end, void* data) {
+	int i;
+
+	for (i = begin; i < end; i++) {
+		profileRecord(STAGE_TRANSFORM, 0, 10);
+	}
+}
+
+int profilerTests(int argc, char** argv) {
+	std::thread threads[profileTestThreads];
+	int failures = 0;
+	int t, e;
+
+	// events recorded while no frame is open are dropped
+	profilerInit();
+	profileRecord(STAGE_SORT, 0, 1000);
+	profilerBeginFrame();
+	profileRecord(STAGE_MOVE, 0, 5);
+	profilerEndFrame();
+	CHECK(profilerFrameCount() == 1);
+	CHECK(profilerFrame(0)->stageTime[STAGE_SORT] == 0);
+	CHECK(profilerFrame(0)->stageTime[STAGE_MOVE] == 5);
+	CHECK(profilerFrame(0)->numEvents == 1);
+
+	// every thread's buffer is merged into the frame when it ends
+	profilerBeginFrame();
+	for (t = 0; t < profileTestThreads; t++) {
+		threads[t] = std::thread(recordEvents, t + 1);
+	}
+	for (t = 0; t < profileTestThreads; t++) {
+		threads[t].join();
+	}
+	profilerEndFrame();
+	const ProfileFrame* frame = profilerFrame(0);
+	int perThread[profileTestThreads + 1] = {};
+	for (e = 0; e < frame->numEvents; e++) {
+		perThread[frame->events[e].thread]++;
+	}
+	CHECK(frame->stageTime[STAGE_RASTER] == profileTestThreads * profileTestEvents * 10);
+	CHECK(frame->numEvents == profileTestThreads * profileTestEvents);
+	for (t = 1; t <= profileTestThreads; t++) {
+		CHECK(perThread[t] == profileTestEvents);
+	}
+
+	// time recorded inside jobs counts in full, whichever threads ran them
+	jobsInit(4);
+	profilerBeginFrame();
+	parallelFor(64, 1, recordRange, nullptr);
+	profilerEndFrame();
+	jobsShutdown();
+	CHECK(profilerFrame(0)->stageTime[STAGE_TRANSFORM] == 64 * 10);
+	CHECK(profilerFrame(0)->numEvents == 64);
+
+	// past profileEvents only the stage time is kept, and the next frame starts empty
+	profilerBeginFrame();
+	for (e = 0; e < profileEvents + 10; e++) {
+		profileRecord(STAGE_CLEAR, 0, 1);
+	}
+	profilerEndFrame();
+	CHECK(profilerFrame(0)->numEvents == profileEvents);
+	CHECK(profilerFrame(0)->stageTime[STAGE_CLEAR] == profileEvents + 10);
+	profilerBeginFrame();
+	profilerEndFrame();
+	CHECK(profilerFrame(0)->numEvents == 0 && profilerFrame(0)->stageTime[STAGE_CLEAR] == 0);
+
+	printf("profiler: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,78 @@
+#include "engine.h"
+#include "render.h"
+#include "sectormap.h"
+#include "tests.h"
+
+// sector containing x/y by testing every sector
+static int bruteFindSector(const MapData* map, int x, int y) {
+	int s;
+
+	for (s = 0; s < map->numSect; s++) {
+		if (pointInSector(map, s, x, y)) {
+			return s;
+		}
+	}
+	return -1;
+}
+
+int sectorTests(int argc, char** argv) {
+	int failures = 0;
+	int x, y, i, k, f;
+
+	// built-in map: four 32x32 boxes, sector 1 spans 64,0 to 96,32
+	Engine* engine = createEngine();
+	CHECK(findSector(engine->map.get(), 16, 16) == 0);
+	CHECK(findSector(engine->map.get(), 80, 16) == 1);
+	CHECK(findSector(engine->map.get(), 80, 80) == 2);
+	CHECK(findSector(engine->map.get(), 16, 80) == 3);
+	CHECK(findSector(engine->map.get(), 48, 48) == -1);
+	CHECK(findSector(engine->map.get(), -500, 16) == -1);
+	CHECK(engine->player.sector == -1);
+
+	// drawing sorts sectors far to near but sector numbers stay the same
+	renderStill(engine);
+	CHECK(findSector(engine->map.get(), 80, 16) == 1);
+	CHECK(engine->map->sectors[1].wallStart == 4);
+
+	// grid lookup and the incremental walk agree with a test of every sector
+	CHECK(loadBoxGrid(engine));
+	int mismatches = 0;
+	int last = -1;
+	for (y = -10; y < 410; y += 3) {
+		for (x = -10; x < 410; x += 3) {
+			int expected = bruteFindSector(engine->map.get(), x, y);
+			if (findSector(engine->map.get(), x, y) != expected) {
+				mismatches++;
+			}
+			last = updateSector(engine->map.get(), last, x, y);
+			if (last != expected) {
+				mismatches++;
+			}
+		}
+	}
+	CHECK(mismatches == 0);
+
+	// boxes further apart than an int can span are still found
+	static int farSectors[2 * 6] = { 0, 4, 0, 40, 2, 3, 4, 8, 0, 40, 2, 3 };
+	static int farWalls[8 * 5];
+	int farStart[5] = { -1100000000 + 12, -1100000000 + 12, 20, 0, 0 };
+	int farCorners[2] = { -1100000000, 1100000000 };
+	for (i = 0; i < 2; i++) {
+		int c = farCorners[i];
+		int box[5][2] = { { c, c }, { c + 256, c }, { c + 256, c + 256 }, { c, c + 256 }, { c, c } };
+		for (k = 0; k < 4; k++) {
+			int wall[5] = { box[k][0], box[k][1], box[k + 1][0], box[k + 1][1], k & 1 };
+			for (f = 0; f < 5; f++) {
+				farWalls[(i * 4 + k) * 5 + f] = wall[f];
+			}
+		}
+	}
+	CHECK(loadMapData(engine, farSectors, 2, farWalls, 8, farStart));
+	CHECK(findSector(engine->map.get(), -1100000000 + 128, -1100000000 + 128) == 0);
+	CHECK(findSector(engine->map.get(), 1100000000 + 128, 1100000000 + 128) == 1);
+	CHECK(findSector(engine->map.get(), 0, 0) == -1);
+
+	destroyEngine(engine);
+	printf("sector: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,86 @@
+#include <cstring>
+#include <vector>
+#include "frameshare.h"
+#include "render.h"
+#include "tests.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// a frame whose every pixel depends on its number
+static void testFrame(int number, unsigned char* frame) {
+	int p;
+
+	for (p = 0; p < SW * SH; p++) {
+		frame[p] = static_cast<unsigned char>((p + number * 7) % 20);
+	}
+}
+
+int shareTests(int argc, char** argv) {
+	int failures = 0;
+	FrameShare writer = FrameShare();
+	FrameShare reader = FrameShare();
+
+#ifdef _WIN32
+	// no shared memory export yet, both sides fail cleanly
+	CHECK(!frameShareCreate(&writer, "sockdoom-test"));
+	CHECK(!frameShareOpen(&reader, "sockdoom-test"));
+#else
+	int i;
+	char name[64];
+	std::vector<unsigned char> frame(SW * SH), read(SW * SH);
+	uint64_t number = 0;
+	int64_t time = 0;
+
+	snprintf(name, sizeof(name), "sockdoom-test-%d", static_cast<int>(getpid()));
+	CHECK(!frameShareOpen(&reader, name));
+	CHECK(frameShareCreate(&writer, name));
+	CHECK(frameShareOpen(&reader, name));
+
+	// the header describes the frames to the reader
+	CHECK(reader.header->width == SW && reader.header->height == SH && reader.header->slots == shareSlots);
+	unsigned char rgb[3];
+	paletteColor(8, rgb);
+	CHECK(memcmp(reader.header->palette[8], rgb, 3) == 0);
+	CHECK(!frameShareRead(&reader, read.data(), &number, &time));
+
+	// the reader always gets the newest frame, also once the ring has wrapped
+	for (i = 1; i <= shareSlots * 2 + 1; i++) {
+		testFrame(i, frame.data());
+		frameSharePublish(&writer, frame.data());
+		CHECK(frameShareRead(&reader, read.data(), &number, &time));
+		CHECK(number == static_cast<uint64_t>(i) && time > 0);
+		CHECK(memcmp(read.data(), frame.data(), SW * SH) == 0);
+	}
+	// readers cannot publish into the ring
+	frameSharePublish(&reader, frame.data());
+	CHECK(reader.header->latest.load() == static_cast<uint64_t>(shareSlots * 2 + 1));
+
+	// a frame overwritten while it was read in place is caught
+	ShareToken token;
+	CHECK(frameShareBegin(&reader, &token) != nullptr);
+	CHECK(frameShareEnd(&reader, &token));
+	for (i = 0; i < shareSlots; i++) {
+		frameSharePublish(&writer, frame.data());
+	}
+	CHECK(!frameShareEnd(&reader, &token));
+	// and so is a slot the writer is still filling
+	writer.header->slot[token.slot].seq.fetch_add(1);
+	CHECK(frameShareBegin(&reader, &token) != nullptr);
+	CHECK(!frameShareEnd(&reader, &token));
+	CHECK(!frameShareRead(&reader, read.data(), &number, &time));
+	writer.header->slot[token.slot].seq.fetch_add(1);
+	CHECK(frameShareRead(&reader, read.data(), &number, &time));
+
+	// the name goes away with the writer, the reader's mapping stays until it closes
+	frameShareClose(&writer);
+	CHECK(reader.header->latest.load() == static_cast<uint64_t>(shareSlots * 3 + 1));
+	FrameShare late = FrameShare();
+	CHECK(!frameShareOpen(&late, name));
+#endif
+	frameShareClose(&reader);
+
+	printf("share: %d failures\n", failures);
+	return failures;
+}
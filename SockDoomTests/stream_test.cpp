@@ -0,0 +1,98 @@
+#include <cstring>
+#include <vector>
+#include "engine.h"
+#include "render.h"
+#include "stream.h"
+#include "tests.h"
+
+// render the player's view after moving it forward by steps units
+static void renderStep(Engine* engine, int steps, unsigned char* frame) {
+	int pose[5];
+
+	pose[0] = engine->map->start[0];
+	pose[1] = engine->map->start[1] + steps;
+	pose[2] = engine->map->start[2];
+	pose[3] = engine->map->start[3];
+	pose[4] = engine->map->start[4];
+	setPose(engine, pose);
+	renderStill(engine);
+	memcpy(frame, engine->view.frameBuffer, SW * SH);
+}
+
+int streamTests(int argc, char** argv) {
+	static StreamServer server;
+	static StreamReader first, second;
+	int failures = 0;
+	int p;
+	uint32_t number = 0;
+	Engine* engine = createEngine();
+	std::vector<unsigned char> a(SW * SH), b(SW * SH), c(SW * SH), decoded(SW * SH);
+	std::vector<unsigned char> message(streamMaxMessage);
+
+	renderStep(engine, 0, a.data());
+	renderStep(engine, 10, b.data());
+	renderStep(engine, 20, c.data());
+
+	// a whole frame rebuilds the frame from nothing, and the flat colors shrink well
+	int keySize = streamEncode(a.data(), a.data(), 1, true, message.data());
+	CHECK(keySize < SW * SH / 4);
+	CHECK(streamDecode(message.data(), keySize, decoded.data(), &number));
+	CHECK(number == 1 && memcmp(decoded.data(), a.data(), SW * SH) == 0);
+
+	// an unchanged frame is only a header, a changed one only its changed tiles
+	CHECK(streamEncode(a.data(), a.data(), 2, false, message.data()) == streamHeaderSize);
+	int deltaSize = streamEncode(a.data(), b.data(), 2, false, message.data());
+	CHECK(deltaSize > streamHeaderSize && deltaSize < keySize);
+	CHECK(streamDecode(message.data(), deltaSize, decoded.data(), &number));
+	CHECK(number == 2 && memcmp(decoded.data(), b.data(), SW * SH) == 0);
+
+	// noise that does not run length encode is sent raw
+	std::vector<unsigned char> noise(a);
+	for (p = 0; p < SW * SH; p += 3) {
+		noise[p] = static_cast<unsigned char>(p * 7 % 12);
+	}
+	int noiseSize = streamEncode(b.data(), noise.data(), 3, false, message.data());
+	CHECK(noiseSize <= streamMaxMessage);
+	CHECK(streamDecode(message.data(), noiseSize, decoded.data(), &number));
+	CHECK(memcmp(decoded.data(), noise.data(), SW * SH) == 0);
+	// and cut off messages are refused
+	CHECK(!streamDecode(message.data(), noiseSize - 1, decoded.data(), &number));
+	message[0] ^= 1;
+	CHECK(!streamDecode(message.data(), noiseSize, decoded.data(), &number));
+
+	// over localhost a viewer gets every frame, one that joins late starts from a whole frame
+	CHECK(streamServerStart(&server, 0));
+	CHECK(server.port > 0);
+	CHECK(streamConnect(&first, "127.0.0.1", server.port));
+	CHECK(streamServerWait(&server, 1000));
+	streamPublish(&server, a.data());
+	CHECK(streamReceive(&first));
+	CHECK(first.number == 1 && memcmp(first.frame, a.data(), SW * SH) == 0);
+	streamPublish(&server, b.data());
+	CHECK(streamReceive(&first));
+	CHECK(first.number == 2 && memcmp(first.frame, b.data(), SW * SH) == 0);
+	long long deltaBytes = first.bytesReceived;
+
+	CHECK(streamConnect(&second, "localhost", server.port));
+	CHECK(streamServerWait(&server, 1000));
+	streamPublish(&server, c.data());
+	CHECK(streamClients(&server) == 2);
+	CHECK(streamReceive(&first));
+	CHECK(streamReceive(&second));
+	CHECK(first.number == 3 && memcmp(first.frame, c.data(), SW * SH) == 0);
+	CHECK(second.number == 3 && memcmp(second.frame, c.data(), SW * SH) == 0);
+	// the first viewer got a delta, the second a whole frame
+	CHECK(first.bytesReceived - deltaBytes < second.bytesReceived);
+
+	// both notice the server going away
+	streamServerStop(&server);
+	CHECK(!streamReceive(&first));
+	CHECK(!streamReceive(&second));
+	streamDisconnect(&first);
+	streamDisconnect(&second);
+
+	destroyEngine(engine);
+
+	printf("stream: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,56 @@
+#include <cstring>
+#include <iostream>
+#include "tests.h"
+
+struct Suite {
+	const char* name;
+	int (*run)(int argc, char** argv);
+};
+
+Suite suites[] = {
+	{ "golden",    goldenTests },
+	{ "collision", collisionTests },
+	{ "sector",    sectorTests },
+	{ "physics",   physicsTests },
+	{ "actor",     actorTests },
+	{ "jobs",      jobsTests },
+	{ "pipeline",  pipelineTests },
+	{ "input",     inputTests },
+	{ "demo",      demoTests },
+	{ "vecenv",    vecEnvTests },
+	{ "views",     viewTests },
+	{ "share",     shareTests },
+	{ "capture",   captureTests },
+	{ "stream",    streamTests },
+	{ "triple",    tripleTests },
+	{ "upscale",   upscaleTests },
+	{ "columns",   columnTests },
+	{ "profiler",  profilerTests },
+};
+
+#define numSuites          (int)(sizeof(suites) / sizeof(suites[0]))
+
+// sockdoom_tests <suite> [suite arguments] runs one suite, no arguments runs them all with their defaults
+int main(int argc, char** argv) {
+	const char* only = (argc > 1) ? argv[1] : nullptr;
+	int i, ran = 0, failures = 0;
+
+	for (i = 0; i < numSuites; i++) {
+		if (only != nullptr && strcmp(only, suites[i].name) != 0) {
+			continue;
+		}
+		std::cout << "== " << suites[i].name << std::endl;
+		failures += (only != nullptr) ? suites[i].run(argc - 2, argv + 2) : suites[i].run(0, argv + argc);
+		ran++;
+	}
+
+	if (ran == 0) {
+		std::cout << "Unknown suite " << only << std::endl;
+		return 1;
+	}
+	if (failures > 0) {
+		std::cout << failures << " failures" << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdio>
+
+// record a failure in the suite's local failures count and keep going
+#define CHECK(cond) \
+	do { \
+		if (!(cond)) { \
+			printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); \
+			failures++; \
+		} \
+	} while (0)
+
+struct Engine;
+
+// load a 10x10 grid of 24x24 boxes 40 units apart, starting at 0,0
+bool loadBoxGrid(Engine* engine);
+
+// each suite takes the arguments after its name and returns its number of failures
+int goldenTests(int argc, char** argv);
+int collisionTests(int argc, char** argv);
+int sectorTests(int argc, char** argv);
+int physicsTests(int argc, char** argv);
+int actorTests(int argc, char** argv);
+int jobsTests(int argc, char** argv);
+int pipelineTests(int argc, char** argv);
+int inputTests(int argc, char** argv);
+int demoTests(int argc, char** argv);
+int vecEnvTests(int argc, char** argv);
+int viewTests(int argc, char** argv);
+int shareTests(int argc, char** argv);
+int captureTests(int argc, char** argv);
+int streamTests(int argc, char** argv);
+int tripleTests(int argc, char** argv);
+int upscaleTests(int argc, char** argv);
+int columnTests(int argc, char** argv);
+int profilerTests(int argc, char** argv);
@@ -0,0 +1,87 @@
+#include <cstring>
+#include <thread>
+#include "triplebuffer.h"
+#include "tests.h"
+
+// defines for triple buffer test settings
+#define tripleTestFrames   2000                    // frames the threaded producer publishes
+
+// fill every pixel with the frame's number
+static void fillFrame(TripleBuffer* buffer, int number) {
+	memset(tripleBack(buffer), number & 255, SW * SH);
+}
+
+// true if every pixel holds the same value
+static bool wholeFrame(const unsigned char* frame) {
+	int i;
+
+	for (i = 1; i < SW * SH; i++) {
+		if (frame[i] != frame[0]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static void produceFrames(TripleBuffer* buffer) {
+	int n;
+
+	for (n = 1; n <= tripleTestFrames; n++) {
+		fillFrame(buffer, n);
+		triplePublish(buffer, n);
+	}
+	tripleClose(buffer);
+}
+
+int tripleTests(int argc, char** argv) {
+	static TripleBuffer buffer;
+	int failures = 0;
+
+	// nothing to take until a frame is published, and each frame is taken once
+	tripleInit(&buffer);
+	CHECK(!tripleTake(&buffer));
+	CHECK(!tripleWait(&buffer, 1));
+	fillFrame(&buffer, 1);
+	triplePublish(&buffer, 1);
+	CHECK(tripleWait(&buffer, 1));
+	CHECK(tripleTake(&buffer));
+	CHECK(tripleFront(&buffer)[0] == 1 && tripleStamp(&buffer) == 1);
+	CHECK(!tripleTake(&buffer));
+
+	// the producer never writes the frame being read, and a slow consumer only sees the newest frame
+	fillFrame(&buffer, 2);
+	triplePublish(&buffer, 2);
+	fillFrame(&buffer, 3);
+	CHECK(tripleBack(&buffer) != tripleFront(&buffer));
+	triplePublish(&buffer, 3);
+	CHECK(tripleFront(&buffer)[0] == 1);
+	CHECK(tripleTake(&buffer));
+	CHECK(tripleFront(&buffer)[0] == 3 && tripleStamp(&buffer) == 3);
+	CHECK(buffer.published == 3 && buffer.dropped == 1);
+
+	// across threads every frame taken is whole and newer than the last, and close ends the wait
+	tripleInit(&buffer);
+	std::thread producer(produceFrames, &buffer);
+	int taken = 0, torn = 0, stale = 0;
+	int64_t last = 0;
+	while (tripleWait(&buffer, 1000) || !tripleClosed(&buffer)) {
+		while (tripleTake(&buffer)) {
+			torn += !wholeFrame(tripleFront(&buffer)) || tripleFront(&buffer)[0] != (tripleStamp(&buffer) & 255);
+			stale += tripleStamp(&buffer) <= last;
+			last = tripleStamp(&buffer);
+			taken++;
+		}
+	}
+	producer.join();
+	// a frame published just before the close may still be waiting
+	if (tripleTake(&buffer)) {
+		last = tripleStamp(&buffer);
+		taken++;
+	}
+	CHECK(torn == 0 && stale == 0);
+	CHECK(last == tripleTestFrames);
+	CHECK(taken + buffer.dropped == tripleTestFrames);
+
+	printf("triple: %d failures\n", failures);
+	return failures;
+}
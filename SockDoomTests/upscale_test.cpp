@@ -0,0 +1,108 @@
+#include <cstring>
+#include <vector>
+#include "engine.h"
+#include "jobs.h"
+#include "render.h"
+#include "tests.h"
+#include "upscale.h"
+
+// straightforward scale2x of one image, with the edges repeating themselves
+static void referenceScale2x(const unsigned char* src, int width, int height, unsigned char* dst) {
+	int x, y;
+
+	for (y = 0; y < height; y++) {
+		for (x = 0; x < width; x++) {
+			int p = src[y * width + x];
+			int a = src[((y + 1 < height) ? y + 1 : y) * width + x];
+			int d = src[((y > 0) ? y - 1 : y) * width + x];
+			int c = src[y * width + ((x > 0) ? x - 1 : x)];
+			int b = src[y * width + ((x + 1 < width) ? x + 1 : x)];
+			unsigned char* lower = &dst[(y * 2) * width * 2 + x * 2];
+			unsigned char* upper = lower + width * 2;
+			upper[0] = static_cast<unsigned char>((c == a && c != d && a != b) ? a : p);
+			upper[1] = static_cast<unsigned char>((a == b && a != c && b != d) ? b : p);
+			lower[0] = static_cast<unsigned char>((d == c && d != b && c != a) ? c : p);
+			lower[1] = static_cast<unsigned char>((b == d && b != a && d != c) ? d : p);
+		}
+	}
+}
+
+// count output pixels that are not the source pixel they cover
+static int nearestMismatches(const unsigned char* src, const Upscaler* upscaler) {
+	int x, y;
+	int mismatches = 0;
+
+	for (y = 0; y < upscaler->height; y++) {
+		for (x = 0; x < upscaler->width; x++) {
+			mismatches += upscaler->out[y * upscaler->width + x] != src[(y / upscaler->factor) * SW + x / upscaler->factor];
+		}
+	}
+	return mismatches;
+}
+
+int upscaleTests(int argc, char** argv) {
+	static Upscaler upscaler;
+	int failures = 0;
+	int factor, threads, p;
+	int jobs = jobThreads();
+	Engine* engine = createEngine();
+	std::vector<unsigned char> noise(SW * SH);
+
+	renderStill(engine);
+	const unsigned char* frame = engine->view.frameBuffer;
+	// few colors, so neighbors often match and every scale2x case comes up
+	for (p = 0; p < SW * SH; p++) {
+		noise[p] = static_cast<unsigned char>((p * 2654435761u >> 13) % 3);
+	}
+
+	// every factor on one thread and several covers each pixel with its own color
+	for (threads = 1; threads <= 4; threads += 3) {
+		jobsInit(threads);
+		int mismatches = 0;
+		for (factor = 1; factor <= maxUpscale; factor++) {
+			CHECK(upscaleInit(&upscaler, factor, UPSCALE_NEAREST));
+			CHECK(upscaler.width == SW * factor && upscaler.height == SH * factor);
+			upscaleFrame(&upscaler, frame);
+			mismatches += nearestMismatches(frame, &upscaler);
+			upscaleFrame(&upscaler, noise.data());
+			mismatches += nearestMismatches(noise.data(), &upscaler);
+		}
+		CHECK(mismatches == 0);
+	}
+
+	// scale2x matches the plain version, once per doubling
+	std::vector<unsigned char> twice(SW * SH * 4), four(SW * SH * 16), eight(SW * SH * 64);
+	const unsigned char* sources[2] = { frame, noise.data() };
+	for (p = 0; p < 2; p++) {
+		referenceScale2x(sources[p], SW, SH, twice.data());
+		referenceScale2x(twice.data(), SW * 2, SH * 2, four.data());
+		referenceScale2x(four.data(), SW * 4, SH * 4, eight.data());
+		CHECK(upscaleInit(&upscaler, 2, UPSCALE_SCALE2X));
+		upscaleFrame(&upscaler, sources[p]);
+		CHECK(memcmp(upscaler.out.data(), twice.data(), twice.size()) == 0);
+		CHECK(upscaleInit(&upscaler, 4, UPSCALE_SCALE2X));
+		upscaleFrame(&upscaler, sources[p]);
+		CHECK(memcmp(upscaler.out.data(), four.data(), four.size()) == 0);
+		CHECK(upscaleInit(&upscaler, 8, UPSCALE_SCALE2X));
+		upscaleFrame(&upscaler, sources[p]);
+		CHECK(memcmp(upscaler.out.data(), eight.data(), eight.size()) == 0);
+	}
+	// and it smooths the diagonal of a half filled square, where nearest leaves steps
+	memset(noise.data(), 0, SW * SH);
+	for (p = 0; p < 8; p++) {
+		memset(&noise[p * SW], 1, 8 - p);
+	}
+	CHECK(upscaleInit(&upscaler, 2, UPSCALE_SCALE2X));
+	upscaleFrame(&upscaler, noise.data());
+	CHECK(upscaler.out[(2 * 3 + 1) * SW * 2 + 2 * 4] == 1 && upscaler.out[(2 * 3 + 1) * SW * 2 + 2 * 4 + 1] == 0);
+
+	// scale2x only doubles
+	CHECK(!upscaleInit(&upscaler, 3, UPSCALE_SCALE2X));
+	CHECK(!upscaleInit(&upscaler, maxUpscale + 1, UPSCALE_NEAREST));
+
+	jobsInit(jobs);
+	destroyEngine(engine);
+
+	printf("upscale: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,107 @@
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "engine.h"
+#include "render.h"
+#include "tests.h"
+#include "vecenv.h"
+
+// defines for vectorized environment test settings
+#define vecEnvTestEnvs     5                       // engines stepped together
+#define vecEnvTestTicks    30                      // ticks each engine is stepped
+
+// keys of engine i on a tick, so every engine goes its own way
+static Keys envKeys(int i, int tick) {
+	Keys input = Keys();
+
+	input.w = (tick + i) % 3 != 0;
+	input.a = i % 2;
+	input.d = i == 4;
+	input.jump = tick == 10 + i;
+	return input;
+}
+
+int vecEnvTests(int argc, char** argv) {
+	static VecEnv env;
+	int failures = 0;
+	int i, t, p;
+	std::vector<Keys> actions(vecEnvTestEnvs);
+
+	// every slot holds the frame a lone engine draws after the same keys
+	CHECK(vecEnvInit(&env, vecEnvTestEnvs, OBS_PALETTE, nullptr));
+	CHECK(vecEnvObservationSize(&env) == static_cast<size_t>(vecEnvTestEnvs) * SW * SH);
+	std::vector<unsigned char> observations(vecEnvObservationSize(&env));
+	Engine* lone[vecEnvTestEnvs];
+	for (i = 0; i < vecEnvTestEnvs; i++) {
+		lone[i] = createEngine();
+	}
+	int mismatches = 0;
+	for (t = 0; t < vecEnvTestTicks; t++) {
+		for (i = 0; i < vecEnvTestEnvs; i++) {
+			actions[i] = envKeys(i, t);
+		}
+		vecEnvStep(&env, actions.data(), observations.data(), nullptr);
+		for (i = 0; i < vecEnvTestEnvs; i++) {
+			lone[i]->keys = actions[i];
+			movePlayer(lone[i]);
+			clearBackground(&lone[i]->view);
+			draw3D(lone[i], &lone[i]->player);
+			arenaReset(&lone[i]->view.frameArena);
+			mismatches += memcmp(&observations[i * SW * SH], lone[i]->view.frameBuffer, SW * SH) != 0;
+		}
+	}
+	CHECK(mismatches == 0);
+	// the engines went different ways
+	CHECK(env.engines[0]->player.angle != env.engines[1]->player.angle);
+	CHECK(memcmp(&observations[0], &observations[SW * SH], SW * SH) != 0);
+	// and the caller's buffer is not left behind in the engines
+	CHECK(env.engines[0]->view.frameBuffer == env.engines[0]->view.frameStorage);
+
+	// reset puts an engine back at the start
+	vecEnvReset(&env, 1);
+	CHECK(env.engines[1]->player.x == 70 && env.engines[1]->player.y == -110);
+	vecEnvFree(&env);
+
+	// rgb observations are the palette colors of the same frames, with a depth for every pixel
+	CHECK(vecEnvInit(&env, vecEnvTestEnvs, OBS_RGB, nullptr));
+	std::vector<unsigned char> rgbObservations(vecEnvObservationSize(&env));
+	std::vector<float> depth(vecEnvTestEnvs * SW * SH);
+	for (i = 0; i < vecEnvTestEnvs; i++) {
+		actions[i] = Keys();
+	}
+	// the sector order settles on the first frame, like renderStill()
+	vecEnvStep(&env, actions.data(), rgbObservations.data(), depth.data());
+	vecEnvStep(&env, actions.data(), rgbObservations.data(), depth.data());
+	// rgb frames are drawn in the engine's own frame buffer first
+	mismatches = 0;
+	for (p = 0; p < SW * SH; p++) {
+		unsigned char rgb[3];
+		paletteColor(env.engines[0]->view.frameBuffer[p], rgb);
+		mismatches += memcmp(&rgbObservations[p * 3], rgb, 3) != 0;
+	}
+	CHECK(mismatches == 0);
+
+	// the start faces the box from 64,0 to 96,32 straight on, 110 units away
+	CHECK(std::fabs(depth[SH2 * SW + SW2] - 110) < 2);
+	// the background has no depth, everything drawn over it does
+	int background = 0, drawn = 0;
+	for (p = 0; p < SW * SH; p++) {
+		if (env.engines[0]->view.frameBuffer[p] == 8) {
+			mismatches += depth[p] != 0;
+			background++;
+		}
+		else {
+			mismatches += !(depth[p] > 0);
+			drawn++;
+		}
+	}
+	CHECK(mismatches == 0 && background > 0 && drawn > 0);
+	vecEnvFree(&env);
+
+	for (i = 0; i < vecEnvTestEnvs; i++) {
+		destroyEngine(lone[i]);
+	}
+
+	printf("vecenv: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,78 @@
+#include <cstring>
+#include <vector>
+#include "engine.h"
+#include "jobs.h"
+#include "render.h"
+#include "tests.h"
+
+// defines for batched view test settings
+#define viewTestCameras    12                      // cameras drawn in one batch
+#define viewTestThreads    4                       // job threads of the threaded batch
+
+// cameras around and inside the box grid, looking every way and from above
+static Player testCamera(int i) {
+	Player camera = Player();
+
+	camera.x = -60 + i * 37;
+	camera.y = 180 - i * 23;
+	camera.z = (i % 3 == 0) ? 90 : 20;
+	camera.angle = (i * 53) % 360;
+	camera.look = (i % 4) - 2;
+	return camera;
+}
+
+int viewTests(int argc, char** argv) {
+	int failures = 0;
+	int i;
+	Engine* engine = createEngine();
+	std::vector<Player> cameras(viewTestCameras);
+	View* views[viewTestCameras];
+	std::vector<float> depth(viewTestCameras * SW * SH);
+	std::vector<float> stillDepth(SW * SH);
+
+	CHECK(loadBoxGrid(engine));
+	for (i = 0; i < viewTestCameras; i++) {
+		cameras[i] = testCamera(i);
+		views[i] = createView();
+		views[i]->depthBuffer = &depth[i * SW * SH];
+	}
+	drawViews(engine, cameras.data(), views, viewTestCameras);
+
+	// every view matches renderStill() from a fresh sector order, pixel for pixel and in depth
+	int mismatches = 0;
+	engine->view.depthBuffer = stillDepth.data();
+	for (i = 0; i < viewTestCameras; i++) {
+		engine->player = cameras[i];
+		resetSectorOrder(&engine->view, engine->map->numSect);
+		renderStill(engine);
+		mismatches += memcmp(views[i]->frameBuffer, engine->view.frameBuffer, SW * SH) != 0;
+		mismatches += memcmp(views[i]->depthBuffer, stillDepth.data(), SW * SH * sizeof(float)) != 0;
+	}
+	engine->view.depthBuffer = nullptr;
+	CHECK(mismatches == 0);
+	// the cameras saw different things
+	CHECK(memcmp(views[0]->frameBuffer, views[1]->frameBuffer, SW * SH) != 0);
+
+	// the same batch gives the same frames spread over several threads
+	std::vector<unsigned char> frames(viewTestCameras * SW * SH);
+	for (i = 0; i < viewTestCameras; i++) {
+		memcpy(&frames[i * SW * SH], views[i]->frameBuffer, SW * SH);
+	}
+	int threads = jobThreads();
+	jobsInit(viewTestThreads);
+	drawViews(engine, cameras.data(), views, viewTestCameras);
+	jobsInit(threads);
+	mismatches = 0;
+	for (i = 0; i < viewTestCameras; i++) {
+		mismatches += memcmp(&frames[i * SW * SH], views[i]->frameBuffer, SW * SH) != 0;
+	}
+	CHECK(mismatches == 0);
+
+	for (i = 0; i < viewTestCameras; i++) {
+		destroyView(views[i]);
+	}
+	destroyEngine(engine);
+
+	printf("views: %d failures\n", failures);
+	return failures;
+}
@@ -0,0 +1,51 @@
+#!/bin/sh
+# Profile guided optimization of sockdoom_core driven by the benchmark camera paths.
+#
+# 1. builds a plain Release baseline and benchmarks it on every map in maps/
+# 2. builds instrumented binaries and runs the same benchmark to collect profiles
+# 3. rebuilds with the profiles and benchmarks again
+# 4. prints the average frame time of every map and path before and after
+#
+# usage: scripts/pgo.sh [build dir] [frames per path]
+# CC/CXX select the compiler, Clang needs llvm-profdata on the PATH.
+set -e
+
+root=$(cd "$(dirname "$0")/.." && pwd)
+build=${1:-"$root/build"}
+frames=${2:-2000}
+profiles="$build/pgo-profiles"
+jobs=$(nproc 2>/dev/null || echo 4)
+
+# run the benchmark on every map and print "map path avg_us" lines
+bench() {
+	for map in "$root"/maps/*.map; do
+		"$1/sockdoom_bench" --frames "$frames" --map "$map" |
+			awk -v map="$(basename "$map" .map)" '$3 == "frames" { print map, $1, $5 }'
+	done
+}
+
+echo "== baseline"
+cmake -S "$root" -B "$build/pgo-baseline" -DCMAKE_BUILD_TYPE=Release -DSOCKDOOM_LTO=ON > /dev/null
+cmake --build "$build/pgo-baseline" --target sockdoom_bench -j "$jobs" > /dev/null
+bench "$build/pgo-baseline" > "$build/pgo-baseline.txt"
+
+# the instrumented and optimized builds share a directory because gcc keys profiles by object path
+echo "== training"
+rm -rf "$profiles"
+cmake -S "$root" -B "$build/pgo" -DCMAKE_BUILD_TYPE=Release -DSOCKDOOM_LTO=ON \
+	-DSOCKDOOM_PGO=GENERATE -DSOCKDOOM_PGO_DIR="$profiles" > /dev/null
+cmake --build "$build/pgo" --target sockdoom_bench -j "$jobs" > /dev/null
+bench "$build/pgo" > /dev/null
+if ls "$profiles"/*.profraw > /dev/null 2>&1; then
+	llvm-profdata merge -output="$profiles/sockdoom.profdata" "$profiles"/*.profraw
+fi
+
+echo "== optimized"
+cmake -S "$root" -B "$build/pgo" -DSOCKDOOM_PGO=USE > /dev/null
+cmake --build "$build/pgo" --target sockdoom_bench -j "$jobs" > /dev/null
+bench "$build/pgo" > "$build/pgo-optimized.txt"
+
+echo
+printf "%-10s %-6s %12s %12s %8s\n" map path "before us" "after us" speedup
+paste "$build/pgo-baseline.txt" "$build/pgo-optimized.txt" |
+	awk '{ printf "%-10s %-6s %12.1f %12.1f %7.2fx\n", $1, $2, $3, $6, $3 / $6 }'